@@ -0,0 +1,27 @@
+/*
+File: IEEE_Cigre_DLLInterface_Export.h
+
+Export and calling-convention decorations of the model entry points, so the same model source builds as a Windows
+DLL or as a Linux shared object:
+
+    IEEE_Cigre_DLLInterface_EXPORT int32_T IEEE_Cigre_DLLInterface_CALL Model_Outputs(IEEE_Cigre_DLLInterface_Instance* instance)
+
+On Windows the entry points are '__declspec(dllexport)' and '__cdecl'. Elsewhere they keep the default visibility,
+so a model built with '-fvisibility=hidden' exports only its entry points, and the calling convention is the
+platform's own.
+*/
+#ifndef __IEEE_Cigre_DLLInterface_Export__
+#define __IEEE_Cigre_DLLInterface_Export__
+
+#if defined(_WIN32)
+#define IEEE_Cigre_DLLInterface_EXPORT __declspec(dllexport)
+#define IEEE_Cigre_DLLInterface_CALL __cdecl
+#elif defined(__GNUC__)
+#define IEEE_Cigre_DLLInterface_EXPORT __attribute__((visibility("default")))
+#define IEEE_Cigre_DLLInterface_CALL
+#else
+#define IEEE_Cigre_DLLInterface_EXPORT
+#define IEEE_Cigre_DLLInterface_CALL
+#endif
+
+#endif /* __IEEE_Cigre_DLLInterface_Export__ */
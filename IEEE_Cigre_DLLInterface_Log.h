@@ -0,0 +1,86 @@
+/*
+File: IEEE_Cigre_DLLInterface_Log.h
+
+Optional logging extension of the IEEE/Cigre DLL interface, not part of the standard. A simulation tool that supports
+it calls the model's 'Model_SetLogSink' once after loading the DLL, handing it a log sink and the lowest level it
+keeps; the model then reports through the sink instead of writing to the console. Tools that do not know the
+extension never call it, and models that do not export it are simply not traced.
+
+Model side: include this header, export 'Model_SetLogSink' ( see below ) and write the messages with
+MODEL_TRACE_LOG( level, fmt, ... ). The macro only exists when the model is compiled with MODEL_TRACE defined; in
+production builds it expands to nothing, so the step function pays nothing for its trace points.
+*/
+#ifndef __IEEE_Cigre_DLLInterface_Log__
+#define __IEEE_Cigre_DLLInterface_Log__
+
+#include "IEEE_Cigre_DLLInterface.h"
+
+
+enum IEEE_Cigre_DLLInterface_Log_Level {
+    IEEE_Cigre_DLLInterface_Log_Debug   = 0,
+    IEEE_Cigre_DLLInterface_Log_Info    = 1,
+    IEEE_Cigre_DLLInterface_Log_Warning = 2,
+    IEEE_Cigre_DLLInterface_Log_Error   = 3
+};
+
+// Receives one message, 'context' is the value given to Model_SetLogSink
+typedef void ( *IEEE_Cigre_DLLInterface_LogSink )( void *context, int32_T level, const char_T *message );
+
+/* Optional entry point:
+typedef int32_T (__cdecl* Model_SetLogSink) (IEEE_Cigre_DLLInterface_LogSink sink, void *context, int32_T level);
+  // Called once per DLL before Model_FirstCall, 'level' is the lowest level the tool keeps.  A NULL 'sink' turns the
+  // logging off.  Returns IEEE_Cigre_DLLInterface_Return_OK.
+*/
+
+
+// ______________________________________________________________________________________________________________________
+// Model side helpers, the sink is shared by every instance of the DLL ( a simulation tool defines
+// IEEE_Cigre_DLLInterface_Log_Host before including this header to leave them out )
+
+#ifndef IEEE_Cigre_DLLInterface_Log_Host
+
+static IEEE_Cigre_DLLInterface_LogSink Model_LogSink = 0;
+static void *Model_LogContext = 0;
+static int32_T Model_LogLevel = IEEE_Cigre_DLLInterface_Log_Error + 1;
+
+// Body of the exported Model_SetLogSink
+static int32_T Model_StoreLogSink(IEEE_Cigre_DLLInterface_LogSink sink, void *context, int32_T level) {
+    Model_LogSink = sink;
+    Model_LogContext = context;
+    Model_LogLevel = level;
+    return 0;
+}
+
+#ifdef MODEL_TRACE
+
+#include <stdio.h>
+#include <stdarg.h>
+
+#define MODEL_TRACE_LINE 256
+
+static void Model_TraceLog(int32_T level, const char_T *fmt, ...) {
+
+    char_T message[MODEL_TRACE_LINE];
+    va_list args;
+
+    if (Model_LogSink == 0 || level < Model_LogLevel) return;
+
+    va_start(args, fmt);
+    vsnprintf(message, sizeof(message), fmt, args);
+    va_end(args);
+
+    Model_LogSink(Model_LogContext, level, message);
+}
+
+#define MODEL_TRACE_LOG(level, ...) Model_TraceLog((level), __VA_ARGS__)
+
+#else
+
+#define MODEL_TRACE_LOG(level, ...) ((void)0)
+
+#endif
+
+#endif /* IEEE_Cigre_DLLInterface_Log_Host */
+
+
+#endif /* __IEEE_Cigre_DLLInterface_Log__ */
@@ -36,10 +36,11 @@ The IEEE/Cigre DLL standard is based on concepts from the IEC 61400-27-1 DLL sta
 
 September 14, 2021, GDI
 */
-#include <windows.h>
 #include <stdio.h>
 
 #include "IEEE_Cigre_DLLInterface.h"
+#include "IEEE_Cigre_DLLInterface_Export.h"             // Entry point decorations ( Windows DLL or Linux shared object )
+#include "IEEE_Cigre_DLLInterface_Log.h"                // MODEL_TRACE_LOG, compiled out unless MODEL_TRACE is defined
 
 char ErrorMessage[1000];
 
@@ -260,14 +261,21 @@ IEEE_Cigre_DLLInterface_Model_Info Model_Info = {
 // ----------------------------------------------------------------
 // Subroutines that can be called by the main power system program
 // ----------------------------------------------------------------
-__declspec(dllexport) const IEEE_Cigre_DLLInterface_Model_Info* __cdecl Model_GetInfo() {
+IEEE_Cigre_DLLInterface_EXPORT const IEEE_Cigre_DLLInterface_Model_Info* IEEE_Cigre_DLLInterface_CALL Model_GetInfo() {
     /* Returns Model Information
     */
     return &Model_Info;
 };
 
 // ----------------------------------------------------------------
-__declspec(dllexport) int32_T __cdecl Model_CheckParameters(IEEE_Cigre_DLLInterface_Instance* instance) {
+IEEE_Cigre_DLLInterface_EXPORT int32_T IEEE_Cigre_DLLInterface_CALL Model_SetLogSink(IEEE_Cigre_DLLInterface_LogSink sink, void *context, int32_T level) {
+    /*   Optional logging extension: stores the log sink of the simulation tool for MODEL_TRACE_LOG
+    */
+    return Model_StoreLogSink(sink, context, level);
+};
+
+// ----------------------------------------------------------------
+IEEE_Cigre_DLLInterface_EXPORT int32_T IEEE_Cigre_DLLInterface_CALL Model_CheckParameters(IEEE_Cigre_DLLInterface_Instance* instance) {
     /*   Checks the parameters on the given range
        Arguments: Instance specific model structure containing Inputs, Parameters and Outputs
        Return:    Integer status 0 (normal), 1 if messages are written, 2 for errors.  See IEEE_Cigre_DLLInterface_types.h
@@ -287,8 +295,8 @@ __declspec(dllexport) int32_T __cdecl Model_CheckParameters(IEEE_Cigre_DLLInterf
     //
     double delt = Model_Info.FixedStepBaseSampleTime;
 
-    printf( "Params: { %f, %f, %f, %f, %f, %f, %i, %f }\n", TAdTB, TB, K, TE, EMin, EMax, CSwitch, RCdRFD );
-    printf( "Params: { %i, %i, %i, %i, %i, %i, %i, %i }\n", sizeof( TAdTB ), sizeof( TB ), sizeof( K ), sizeof( TE ), sizeof( EMin ), sizeof( EMax ), sizeof( CSwitch ), sizeof( RCdRFD ) );
+    MODEL_TRACE_LOG( IEEE_Cigre_DLLInterface_Log_Debug, "Params: { %f, %f, %f, %f, %f, %f, %i, %f }\n", TAdTB, TB, K, TE, EMin, EMax, CSwitch, RCdRFD );
+    MODEL_TRACE_LOG( IEEE_Cigre_DLLInterface_Log_Debug, "Params: { %i, %i, %i, %i, %i, %i, %i, %i }\n", (int)sizeof( TAdTB ), (int)sizeof( TB ), (int)sizeof( K ), (int)sizeof( TE ), (int)sizeof( EMin ), (int)sizeof( EMax ), (int)sizeof( CSwitch ), (int)sizeof( RCdRFD ) );
     
 
     ErrorMessage[0] = '\0';
@@ -304,13 +312,13 @@ __declspec(dllexport) int32_T __cdecl Model_CheckParameters(IEEE_Cigre_DLLInterf
     }
     instance->LastGeneralMessage = ErrorMessage;
 
-    printf( "Params After0: { %f, %f, %f, %f, %f, %f, %i, %f }\n", TAdTB, TB, K, TE, EMin, EMax, CSwitch, RCdRFD );
-    printf( "Params After: { %f, %f, %f, %f, %f, %f, %i, %f }\n", TAdTB, parameters->TB, K, parameters->TE, EMin, EMax, CSwitch, RCdRFD );
+    MODEL_TRACE_LOG( IEEE_Cigre_DLLInterface_Log_Debug, "Params After0: { %f, %f, %f, %f, %f, %f, %i, %f }\n", TAdTB, TB, K, TE, EMin, EMax, CSwitch, RCdRFD );
+    MODEL_TRACE_LOG( IEEE_Cigre_DLLInterface_Log_Debug, "Params After: { %f, %f, %f, %f, %f, %f, %i, %f }\n", TAdTB, parameters->TB, K, parameters->TE, EMin, EMax, CSwitch, RCdRFD );
     return IEEE_Cigre_DLLInterface_Return_OK;
 };
 
 // ----------------------------------------------------------------
-__declspec(dllexport) int32_T __cdecl Model_Initialize(IEEE_Cigre_DLLInterface_Instance* instance) {
+IEEE_Cigre_DLLInterface_EXPORT int32_T IEEE_Cigre_DLLInterface_CALL Model_Initialize(IEEE_Cigre_DLLInterface_Instance* instance) {
     /*   Initializes the system by resetting the internal states
        Arguments: Instance specific model structure containing Inputs, Parameters and Outputs
        Return:    Integer status 0 (normal), 1 if messages are written, 2 for errors.  See IEEE_Cigre_DLLInterface_types.h
@@ -348,7 +356,7 @@ __declspec(dllexport) int32_T __cdecl Model_Initialize(IEEE_Cigre_DLLInterface_I
     double VUEL = inputs->VUEL;
     double VOEL = inputs->VOEL;
 
-    printf( "Params ModelInit: { %f, %f, %f, %f, %f, %f, %i, %f }\n", TAdTB, TB, K, TE, EMin, EMax, CSwitch, RCdRFD );
+    MODEL_TRACE_LOG( IEEE_Cigre_DLLInterface_Log_Debug, "Params ModelInit: { %f, %f, %f, %f, %f, %f, %i, %f }\n", TAdTB, TB, K, TE, EMin, EMax, CSwitch, RCdRFD );
 
     // Working back from initial output
     MyModelOutputs* outputs = (MyModelOutputs*)instance->ExternalOutputs;
@@ -417,7 +425,7 @@ double LEADLAG(double G, double T1, double T2, double x, double x_old, double y_
 
 
 // ----------------------------------------------------------------
-__declspec(dllexport) int32_T __cdecl Model_Outputs(IEEE_Cigre_DLLInterface_Instance* instance) {
+IEEE_Cigre_DLLInterface_EXPORT int32_T IEEE_Cigre_DLLInterface_CALL Model_Outputs(IEEE_Cigre_DLLInterface_Instance* instance) {
     /*   Calculates output equation
        Arguments: Instance specific model structure containing Inputs, Parameters and Outputs
        Return:    Integer status 0 (normal), 1 if messages are written, 2 for errors.  See IEEE_Cigre_DLLInterface_types.h
@@ -493,20 +501,20 @@ __declspec(dllexport) int32_T __cdecl Model_Outputs(IEEE_Cigre_DLLInterface_Inst
     instance->DoubleStates[5] = S_OLeadLag;
     instance->LastGeneralMessage = ErrorMessage;
 
-    printf( "ModelOutput= %f\n", outputs->EFD );
+    MODEL_TRACE_LOG( IEEE_Cigre_DLLInterface_Log_Debug, "ModelOutput= %f\n", outputs->EFD );
 
     return IEEE_Cigre_DLLInterface_Return_OK;
 };
 
 // ----------------------------------------------------------------
-__declspec(dllexport) int32_T __cdecl Model_Terminate(IEEE_Cigre_DLLInterface_Instance* instance) {
+IEEE_Cigre_DLLInterface_EXPORT int32_T IEEE_Cigre_DLLInterface_CALL Model_Terminate(IEEE_Cigre_DLLInterface_Instance* instance) {
     /*   Destroys any objects allocated by the model code - not used
     */
 
     return IEEE_Cigre_DLLInterface_Return_OK;
 };
 // ----------------------------------------------------------------
-__declspec(dllexport) int32_T __cdecl Model_PrintInfo() {
+IEEE_Cigre_DLLInterface_EXPORT int32_T IEEE_Cigre_DLLInterface_CALL Model_PrintInfo() {
     /* Prints Model Information once
     */
     int Printed = 0;
@@ -0,0 +1,90 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "atp_stub.h"
+
+
+jmp_buf atpStubStop;
+int atpStubArmed= 0;
+
+static char *capture= NULL;
+static size_t captureSize= 0;
+static size_t captureCap= 0;
+static long captureLines= 0;
+static FILE *echoFile= NULL;
+static char stopMessage[256]= "";
+
+
+void atpStubEcho( FILE *pFile ) {
+  echoFile= pFile;
+}
+
+const char* atpStubCapture( void ) {
+  return ( capture != NULL ) ? capture : "";
+}
+
+long atpStubLines( void ) {
+  return captureLines;
+}
+
+void atpStubClear( void ) {
+
+  captureSize= 0;
+  captureLines= 0;
+  if ( capture != NULL ) capture[0]= '\0';
+
+}
+
+const char* atpStubStopMessage( void ) {
+  return stopMessage;
+}
+
+// One '.LIS' line, 'length' bytes of 'text' ( not '\0' terminated for Fortran )
+void outsix_( char *text, int32_T *length ) {
+
+  size_t len= ( *length > 0 ) ? ( size_t ) *length : 0;
+
+  if ( captureSize + len + 2 > captureCap ) {
+
+    size_t newCap= ( captureCap > 0 ) ? 2 * captureCap : 64 * 1024;
+    while ( newCap < captureSize + len + 2 ) newCap *= 2;
+
+    char *grown= realloc( capture, newCap );
+    if ( grown == NULL ) {
+      fprintf( stderr, "outsix_: out of memory for the capture\n" );
+      exit( EXIT_FAILURE );
+    }
+
+    capture= grown;
+    captureCap= newCap;
+  }
+
+  memcpy( capture + captureSize, text, len );
+  captureSize += len;
+  capture[ captureSize++ ]= '\n';                                                                            // One record per call, as in the '.LIS' file
+  capture[ captureSize ]= '\0';
+  captureLines++;
+
+  if ( echoFile != NULL ) {
+    fprintf( echoFile, "%.*s\n", ( int ) len, text );
+  }
+
+}
+
+void stoptp_( char *text, int *length ) {
+
+  snprintf( stopMessage, sizeof( stopMessage ), "%.*s", *length, text );
+
+  if ( echoFile != NULL ) {
+    fprintf( echoFile, "STOP: %s\n", stopMessage );
+  }
+
+  if ( atpStubArmed ) {
+    atpStubArmed= 0;
+    longjmp( atpStubStop, 1 );
+  }
+
+  fprintf( stderr, "STOP: %s\n", stopMessage );
+  exit( EXIT_FAILURE );
+
+}
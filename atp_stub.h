@@ -0,0 +1,39 @@
+/*
+File: atp_stub.h
+
+Stand-in for the ATP runtime routines dll_one calls, to build and drive the wrapper outside tpbig:
+- 'outsix_' appends every '.LIS' line to an in-memory capture and, optionally, echoes it to a file
+- 'stoptp_' records the stop message and 'longjmp's back to the driver ( ATP_STUB_TRY ), or exits when not armed
+*/
+#ifndef __atp_stub__
+#define __atp_stub__
+
+#include <stdio.h>
+#include <setjmp.h>
+#include "IEEE_Cigre_DLLInterface.h"
+
+
+extern jmp_buf atpStubStop;
+extern int atpStubArmed;
+
+// 0 when armed, non-zero after a 'stoptp_' call came back here
+#define ATP_STUB_TRY() ( atpStubArmed= 1, setjmp( atpStubStop ) )
+
+
+// ATP routines
+void outsix_( char *text, int32_T *length );
+void stoptp_( char *text, int *length );
+
+// Echo the '.LIS' lines to 'pFile' as well ( NULL: capture only )
+void atpStubEcho( FILE *pFile );
+
+// Captured '.LIS' text and number of lines since the last clear
+const char* atpStubCapture( void );
+long atpStubLines( void );
+void atpStubClear( void );
+
+// Message of the last 'stoptp_' call, empty if the simulation was not stopped
+const char* atpStubStopMessage( void );
+
+
+#endif /* __atp_stub__ */
@@ -0,0 +1,323 @@
+/*
+File: contingency_fork.c
+
+Contingency screening driver for a set of IEEE/Cigre models built as Linux shared objects. Every model of the set
+runs once with its base inputs up to the branching time T, then fork() gives one child per contingency of that
+model: every child starts from the warm state shared copy-on-write with the parent, applies its input perturbation
+and streams the outputs to its own file. Only the post-event part of the simulation is run K times per model, and the
+children of every model run side by side.
+
+Usage:
+  contingency_fork <scenarios.txt> <T> <tEnd> [outPrefix]
+
+Scenario file ( '#' starts a comment ), one section per model of the set:
+  model <model.so> [label]              starts the section of a model ( default label: its ModelName )
+  inputs <v1> <v2> ...                  base input values, exactly one per ATP value ( array ports take 'Width' values )
+  param <name> <value>                  parameter override ( default: DefaultValue of the model )
+  event <name> <i>=<value> ...          one contingency: 1-based input values replaced from T on
+
+Each child writes '<outPrefix>_<label>_<name>.txt' ( default prefix: 'contingency' ) with the time and the output
+values of every model step from T on.
+
+Build: make contingency_fork
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include "IEEE_Cigre_DLLInterface.h"
+#include "dll_one_run.h"
+
+
+#define MAX_MODELS 64
+#define MAX_EVENTS 256                                                        // Per model
+#define MAX_EVENT_CHANGES 64
+#define OUTPUT_BUFFER_SIZE ( 1 << 20 )                                        // stdio buffer of every result file
+
+
+// Input values replaced by one contingency
+typedef struct _ContingencyEvent {
+  char name[64];
+  int32_T numChanges;
+  int32_T index[ MAX_EVENT_CHANGES ];                                         // 0-based input value
+  double value[ MAX_EVENT_CHANGES ];
+} ContingencyEvent;
+
+// One model of the set and its contingencies
+typedef struct _ContingencyModel {
+  char label[64];                                                             // Result file names
+  ModelRun run;
+
+  ContingencyEvent *events;                                                   // 'MAX_EVENTS' entries
+  int32_T numEvents;
+  pid_t *children;                                                            // One per event
+} ContingencyModel;
+
+
+static ContingencyModel models[ MAX_MODELS ];
+static int32_T numModels= 0;
+
+
+static void readScenarios( const char *scenarioFile ) {
+
+  FILE *pFile= fopen( scenarioFile, "r" );
+  if ( pFile == NULL ) hostFail( "Could not read scenarios: ", scenarioFile );
+
+  ContingencyModel *model= NULL;
+  char line[4096];
+
+  while ( fgets( line, sizeof( line ), pFile ) != NULL ) {
+
+    line[ strcspn( line, "#\r\n" ) ]= '\0';
+    char *word= strtok( line, " \t" );
+    if ( word == NULL ) continue;
+
+    if ( strcmp( word, "model" ) == 0 ) {
+
+      char *modelFile= strtok( NULL, " \t" );
+      char *label= strtok( NULL, " \t" );
+      int32_T k;
+
+      if ( modelFile == NULL ) hostFail( "'model' line without a model in ", scenarioFile );
+      if ( numModels == MAX_MODELS ) hostFail( "Too many models in ", scenarioFile );
+
+      model= &models[ numModels++ ];
+      loadModelRun( &model -> run, modelFile );
+      snprintf( model -> label, sizeof( model -> label ), "%s", label != NULL ? label : model -> run.modelInfo -> ModelName );
+
+      for ( k= 0; k < numModels - 1; k++ ) {
+        if ( strcmp( models[k].label, model -> label ) == 0 ) hostFail( "Two models with the same label, add one to the 'model' line: ", model -> label );
+      }
+
+      model -> events= calloc( MAX_EVENTS, sizeof( ContingencyEvent ) );
+      if ( model -> events == NULL ) hostFail( "Memory allocation failed for the events", NULL );
+      continue;
+    }
+
+    if ( model == NULL ) hostFail( "Scenario line before the first 'model' line: ", word );
+
+    ModelRun *run= &model -> run;
+    IEEE_Cigre_DLLInterface_Model_Info *modelInfo= run -> modelInfo;
+
+    if ( strcmp( word, "inputs" ) == 0 ) {
+
+      int32_T i= 0;
+      while ( ( word= strtok( NULL, " \t" ) ) != NULL ) {
+        if ( i == run -> inputs.numValues ) hostFail( "More 'inputs' values than the model takes: ", model -> label );
+        run -> inputValues[ i++ ]= atof( word );
+      }
+
+      if ( i < run -> inputs.numValues ) hostFail( "Fewer 'inputs' values than the model takes: ", model -> label );
+
+    } else if ( strcmp( word, "param" ) == 0 ) {
+
+      char *name= strtok( NULL, " \t" );
+      char *value= strtok( NULL, " \t" );
+      int32_T i;
+
+      if ( name == NULL || value == NULL ) hostFail( "Invalid 'param' line in ", scenarioFile );
+
+      for ( i= 0; i < modelInfo -> NumParameters; i++ ) {
+        if ( strcmp( modelInfo -> ParametersInfo[i].Name, name ) == 0 ) break;
+      }
+
+      if ( i == modelInfo -> NumParameters ) hostFail( "Unknown parameter: ", name );
+      run -> paramValues[i]= atof( value );
+
+    } else if ( strcmp( word, "event" ) == 0 ) {
+
+      if ( model -> numEvents == MAX_EVENTS ) hostFail( "Too many events for model ", model -> label );
+
+      ContingencyEvent *event= &model -> events[ model -> numEvents++ ];
+      char *name= strtok( NULL, " \t" );
+
+      if ( name == NULL ) hostFail( "Event without a name in ", scenarioFile );
+      snprintf( event -> name, sizeof( event -> name ), "%s", name );
+
+      while ( ( word= strtok( NULL, " \t" ) ) != NULL ) {
+
+        char *eq= strchr( word, '=' );
+        int32_T index= atoi( word ) - 1;
+
+        if ( eq == NULL || index < 0 || index >= run -> inputs.numValues ) hostFail( "Invalid input change: ", word );
+        if ( event -> numChanges == MAX_EVENT_CHANGES ) hostFail( "Too many input changes in event ", event -> name );
+
+        event -> index[ event -> numChanges ]= index;
+        event -> value[ event -> numChanges++ ]= atof( eq + 1 );
+      }
+
+    } else {
+      hostFail( "Unknown scenario line: ", word );
+    }
+
+  }
+
+  fclose( pFile );
+
+  if ( numModels == 0 ) hostFail( "No models in ", scenarioFile );
+
+  int32_T k;
+  for ( k= 0; k < numModels; k++ ) {
+    if ( models[k].numEvents == 0 ) hostFail( "No events for model ", models[k].label );
+  }
+
+}
+
+// One model step with the current input values
+static inline void stepModel( ModelRun *run, double t ) {
+
+  if ( !run -> inputs.zeroCopy ) {
+    changeDataType( run -> inputValues, &run -> inputs, run -> instance.ExternalInputs );
+  }
+  run -> instance.Time= t;
+  checkModelCall( run, "Model_Outputs", run -> entries.modelOutputs( &run -> instance ) );
+
+}
+
+// Child process: apply the event and simulate from T to tEnd, streaming the outputs
+static int runContingency( ContingencyModel *model, const ContingencyEvent *event, int64_t firstStep, int64_t lastStep, const char *outPrefix ) {
+
+  ModelRun *run= &model -> run;
+  char path[512];
+  snprintf( path, sizeof( path ), "%s_%s_%s.txt", outPrefix, model -> label, event -> name );
+
+  FILE *pFile= fopen( path, "w" );
+  if ( pFile == NULL ) {
+    fprintf( stderr, "Cannot write %s\n", path );
+    return EXIT_FAILURE;
+  }
+
+  setvbuf( pFile, NULL, _IOFBF, OUTPUT_BUFFER_SIZE );
+
+  int32_T i;
+  for ( i= 0; i < event -> numChanges; i++ ) {
+    run -> inputValues[ event -> index[i] ]= event -> value[i];
+  }
+
+  double dt= run -> modelInfo -> FixedStepBaseSampleTime;
+  int64_t n;
+
+  for ( n= firstStep; n <= lastStep; n++ ) {
+
+    double t= n * dt;
+    stepModel( run, t );
+    writeValuesToATP( run -> instance.ExternalOutputs, &run -> outputs, run -> outputValues );
+
+    fprintf( pFile, "%.9g", t );
+    for ( i= 0; i < run -> outputs.numValues; i++ ) {
+      fprintf( pFile, " %.12g", run -> outputValues[i] );
+    }
+    fputc( '\n', pFile );
+
+  }
+
+  // No Model_Terminate: the parent calls it once for the instance every child was copied from
+
+  return ( fclose( pFile ) == 0 ) ? EXIT_SUCCESS : EXIT_FAILURE;
+
+}
+
+
+// Parent process: initialize the model, run its base case up to T and fork one child per contingency
+static void branchModel( ContingencyModel *model, double tBranch, double tEnd, const char *outPrefix ) {
+
+  ModelRun *run= &model -> run;
+  double dt= run -> modelInfo -> FixedStepBaseSampleTime;
+  int64_t branchStep= ( int64_t )( tBranch / dt + 0.5 );
+  if ( branchStep < 1 ) branchStep= 1;                                                                        // The first step is n= 1
+  int64_t lastStep= ( int64_t )( tEnd / dt + 0.5 );
+
+  printf( "Model= %s ( %s ) - dt= %g - T= %g ( step %lld ) - tEnd= %g - %d contingencies\n",
+          model -> label, run -> modelInfo -> ModelName, dt, tBranch, ( long long ) branchStep, tEnd, model -> numEvents );
+
+
+  // Common part: initialization and the base case up to T, stepped as model_runner does ( t= n * dt from n= 1, the
+  // initialization covers t= 0 )
+
+  if ( !run -> inputs.zeroCopy ) {
+    changeDataType( run -> inputValues, &run -> inputs, run -> instance.ExternalInputs );
+  }
+  initializeModelRun( run, 0 );
+
+  int64_t n;
+  for ( n= 1; n < branchStep; n++ ) {
+    stepModel( run, n * dt );
+  }
+
+  fflush( stdout );
+
+
+  // One child per contingency, sharing the warm state copy-on-write
+
+  model -> children= malloc( model -> numEvents * sizeof( pid_t ) );
+  if ( model -> children == NULL ) hostFail( "Memory allocation failed for the children", NULL );
+
+  int32_T k;
+  for ( k= 0; k < model -> numEvents; k++ ) {
+
+    model -> children[k]= fork();
+
+    if ( model -> children[k] < 0 ) {
+      perror( "fork" );
+      exit( EXIT_FAILURE );
+    }
+
+    if ( model -> children[k] == 0 ) {
+      _exit( runContingency( model, &model -> events[k], branchStep, lastStep, outPrefix ) );
+    }
+
+  }
+
+}
+
+
+int main( int argc, char *argv[] ) {
+
+  if ( argc < 4 ) {
+    printf( "Usage: %s <scenarios.txt> <T> <tEnd> [outPrefix]\n", argv[0] );
+    return EXIT_FAILURE;
+  }
+
+  const char *outPrefix= ( argc > 4 ) ? argv[4] : "contingency";
+  double tBranch= atof( argv[2] );
+  double tEnd= atof( argv[3] );
+
+  readScenarios( argv[1] );
+
+  // The base case of the next model runs while the children of the previous ones do
+  int32_T m, k;
+  for ( m= 0; m < numModels; m++ ) {
+    branchModel( &models[m], tBranch, tEnd, outPrefix );
+  }
+
+  int failed= 0;
+  for ( m= 0; m < numModels; m++ ) {
+
+    ContingencyModel *model= &models[m];
+
+    for ( k= 0; k < model -> numEvents; k++ ) {
+
+      int status;
+      waitpid( model -> children[k], &status, 0 );
+
+      if ( !WIFEXITED( status ) || WEXITSTATUS( status ) != EXIT_SUCCESS ) {
+        printf( "Contingency %s/%s failed\n", model -> label, model -> events[k].name );
+        failed++;
+      } else {
+        printf( "Contingency %s/%s -> %s_%s_%s.txt\n", model -> label, model -> events[k].name, outPrefix, model -> label, model -> events[k].name );
+      }
+
+    }
+
+    free( model -> children );
+
+    if ( model -> run.entries.modelTerminate != NULL ) {
+      model -> run.entries.modelTerminate( &model -> run.instance );
+    }
+
+  }
+
+  return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+
+}
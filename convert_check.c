@@ -0,0 +1,150 @@
+/*
+File: convert_check.c
+
+Check of the conversion kernels ( dll_one_convert.c ): the SSE2 and AVX2 kernels of every data type must give the
+same bytes as the scalar ones. The inputs are the edge values of each conversion ( NaN, +-inf, values out of the
+range of the narrow integer types, the 2^31 boundary of 'uint32_T', real32 overflow and denormals ), at every length
+up to a few vectors so that each tail length is covered, and from unaligned starts. The bytes past 'count' must stay
+untouched. Instruction sets the processor lacks are reported and skipped.
+
+Usage:
+  convert_check
+
+Build and run: make check_convert
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "dll_one_convert.h"
+
+
+#define MAX_COUNT 37                                                          // Several AVX2 vectors and every tail length
+#define MAX_SHIFT 3                                                           // Unaligned starts
+#define GUARD 16                                                              // Bytes past 'count' that must stay untouched
+#define BUFFER_SIZE ( ( MAX_COUNT + MAX_SHIFT ) * 8 + GUARD )
+
+#define FIRST_TYPE IEEE_Cigre_DLLInterface_DataType_char_T                    // Numeric types, 'char_T' to 'real64_T'
+#define NUM_TYPES 9
+
+
+static const char *typeNames[ NUM_TYPES ]= { "char_T", "int8_T", "uint8_T", "int16_T", "uint16_T", "int32_T", "uint32_T", "real32_T", "real64_T" };
+static const int32_T typeSizes[ NUM_TYPES ]= { 1, 1, 1, 2, 2, 4, 4, 4, 8 };
+
+
+// ATP values at the edges of every model data type
+static double atpValues[ MAX_COUNT + MAX_SHIFT ];
+
+static void fillATPValues( void ) {
+
+  const double edges[]= { 0.0, -0.0, 0.5, -0.5, 1.9, -1.9, 127.0, 128.0, -128.0, -129.0, 255.0, 256.0, 32767.0, 32768.0,
+                          -32769.0, 65535.0, 65536.0, 2147483647.0, 2147483647.9, 2147483648.0, -2147483648.0, -2147483649.0,
+                          4294967295.0, 4294967296.0, 1e300, -1e300, NAN, -NAN, INFINITY, -INFINITY, 4e-320, 3.5e38, -3.5e38,
+                          1e-50, 3.4028234663852886e38, 1.5, -2.5 };
+  const int32_T numEdges= ( int32_T )( sizeof( edges ) / sizeof( edges[0] ) );
+  int32_T k;
+
+  for ( k= 0; k < MAX_COUNT + MAX_SHIFT; k++ ) atpValues[k]= edges[ k % numEdges ];
+
+}
+
+// Model values with every bit pattern at the edges of its type: 0, the extremes, the sign bit, NaN and inf for real32
+static uint8_T modelValues[ ( MAX_COUNT + MAX_SHIFT ) * 8 ];
+
+static void fillModelValues( int32_T size ) {
+
+  const uint32_T edges32[]= { 0x00000000u, 0x00000001u, 0x7FFFFFFFu, 0x80000000u, 0xFFFFFFFFu, 0x7F800000u, 0xFF800000u,
+                              0x7FC00000u, 0xFFC00001u, 0x00000010u, 0x3F800000u, 0xBF7FFFFFu, 0x0000FF80u, 0x00007FFFu };
+  const int32_T numEdges= ( int32_T )( sizeof( edges32 ) / sizeof( edges32[0] ) );
+  int32_T k;
+
+  for ( k= 0; k < MAX_COUNT + MAX_SHIFT; k++ ) {
+
+    uint32_T bits= edges32[ k % numEdges ];
+
+    // Narrow types take the low and the high end of the pattern in turn
+    if ( size == 1 ) modelValues[k]= ( uint8_T )( bits >> ( ( k & 1 ) ? 24 : 0 ) );
+    else if ( size == 2 ) { uint16_T v= ( uint16_T )( bits >> ( ( k & 1 ) ? 16 : 0 ) ); memcpy( modelValues + 2 * k, &v, 2 ); }
+    else memcpy( modelValues + 4 * k, &bits, 4 );
+  }
+
+}
+
+
+// Run one kernel on a guarded buffer
+static void runToModel( DllToModelKernel kernel, int32_T shift, int32_T count, uint8_T *out ) {
+  memset( out, 0xA5, BUFFER_SIZE );
+  kernel( atpValues + shift, out, count );
+}
+
+static void runToATP( DllToATPKernel kernel, int32_T size, int32_T shift, int32_T count, uint8_T *out ) {
+  memset( out, 0xA5, BUFFER_SIZE );
+  kernel( modelValues + size * shift, ( double * ) out, count );
+}
+
+
+// Compare the kernels of 'isa' with the scalar ones, returns the number of mismatches
+static int32_T checkKernels( const char *isa ) {
+
+  static uint8_T expected[ BUFFER_SIZE ], actual[ BUFFER_SIZE ];
+  DllToModelKernel scalarToModel[ NUM_TYPES ], isaToModel[ NUM_TYPES ];
+  DllToATPKernel scalarToATP[ NUM_TYPES ], isaToATP[ NUM_TYPES ];
+  int32_T type, shift, count, failed= 0;
+
+  useConvertKernels( "scalar" );
+  for ( type= 0; type < NUM_TYPES; type++ ) {
+    scalarToModel[ type ]= toModelKernel( FIRST_TYPE + type );
+    scalarToATP[ type ]= toATPKernel( FIRST_TYPE + type );
+  }
+
+  if ( !useConvertKernels( isa ) ) {
+    printf( "%s: not supported by this processor, skipped\n", isa );
+    return 0;
+  }
+
+  for ( type= 0; type < NUM_TYPES; type++ ) {
+    isaToModel[ type ]= toModelKernel( FIRST_TYPE + type );
+    isaToATP[ type ]= toATPKernel( FIRST_TYPE + type );
+  }
+
+  for ( type= 0; type < NUM_TYPES; type++ ) {
+
+    int32_T size= typeSizes[ type ];
+    fillModelValues( size );
+
+    for ( shift= 0; shift <= MAX_SHIFT; shift++ ) {
+      for ( count= 0; count <= MAX_COUNT; count++ ) {
+
+        runToModel( scalarToModel[ type ], shift, count, expected );
+        runToModel( isaToModel[ type ], shift, count, actual );
+
+        if ( memcmp( expected, actual, BUFFER_SIZE ) != 0 ) {
+          if ( failed++ < 20 ) printf( "%s: ATP -> %s differs from scalar, start %d, count %d\n", isa, typeNames[ type ], shift, count );
+        }
+
+        runToATP( scalarToATP[ type ], size, shift, count, expected );
+        runToATP( isaToATP[ type ], size, shift, count, actual );
+
+        if ( memcmp( expected, actual, BUFFER_SIZE ) != 0 ) {
+          if ( failed++ < 20 ) printf( "%s: %s -> ATP differs from scalar, start %d, count %d\n", isa, typeNames[ type ], shift, count );
+        }
+
+      }
+    }
+  }
+
+  printf( "%s: %s\n", isa, failed ? "FAILED" : "same bytes as scalar" );
+  return failed;
+
+}
+
+
+int main( void ) {
+
+  fillATPValues();
+
+  int32_T failed= checkKernels( "sse2" ) + checkKernels( "avx2" );
+
+  return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+
+}
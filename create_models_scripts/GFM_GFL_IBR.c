@@ -113,12 +113,13 @@ The IEEE/Cigre DLL standard is based on concepts from the IEC 61400-27-1 DLL sta
 This is a draft model that may still need further modifications and improvements
 January 27, 2022, Deepak Ramasubramanian, EPRI (dramasubramanian@epri.com)
 */
-//#include <windows.h>
 #include <stdio.h>
 #include <math.h>
 #define PI 3.14159265
 
 #include "IEEE_Cigre_DLLInterface.h"
+#include "IEEE_Cigre_DLLInterface_Export.h"             // Entry point decorations ( Windows DLL or Linux shared object )
+#include "IEEE_Cigre_DLLInterface_Log.h"                // MODEL_TRACE_LOG, compiled out unless MODEL_TRACE is defined
 
 char ErrorMessage[1000];
 
@@ -829,14 +830,21 @@ IEEE_Cigre_DLLInterface_Model_Info Model_Info = {
 // ----------------------------------------------------------------
 // Subroutines that can be called by the main power system program
 // ----------------------------------------------------------------
-__declspec(dllexport) const IEEE_Cigre_DLLInterface_Model_Info* __cdecl Model_GetInfo() {
+IEEE_Cigre_DLLInterface_EXPORT const IEEE_Cigre_DLLInterface_Model_Info* IEEE_Cigre_DLLInterface_CALL Model_GetInfo() {
   /* Returns Model Information
   */
   return &Model_Info;
 };
 
 // ----------------------------------------------------------------
-__declspec(dllexport) int32_T __cdecl Model_CheckParameters(IEEE_Cigre_DLLInterface_Instance* instance) {
+IEEE_Cigre_DLLInterface_EXPORT int32_T IEEE_Cigre_DLLInterface_CALL Model_SetLogSink(IEEE_Cigre_DLLInterface_LogSink sink, void *context, int32_T level) {
+  /*   Optional logging extension: stores the log sink of the simulation tool for MODEL_TRACE_LOG
+  */
+  return Model_StoreLogSink(sink, context, level);
+};
+
+// ----------------------------------------------------------------
+IEEE_Cigre_DLLInterface_EXPORT int32_T IEEE_Cigre_DLLInterface_CALL Model_CheckParameters(IEEE_Cigre_DLLInterface_Instance* instance) {
   /*   Checks the parameters on the given range
       Arguments: Instance specific model structure containing Inputs, Parameters and Outputs
       Return:    Integer status 0 (normal), 1 if messages are written, 2 for errors.  See IEEE_Cigre_DLLInterface_types.h
@@ -892,35 +900,36 @@ __declspec(dllexport) int32_T __cdecl Model_CheckParameters(IEEE_Cigre_DLLInterf
   ErrorMessage[0] = '\0';
   if ((1.0/KiI) < 2.0*delt) {
     // write error message
-    sprintf(ErrorMessage, sizeof(ErrorMessage), "GFL-IBR Error - Parameter KiI is: %f, but has been reset to be reciprocal of 2 times the time step: %f .\n", KiI, delt);
+    snprintf(ErrorMessage, sizeof(ErrorMessage), "GFL-IBR Error - Parameter KiI is: %f, but has been reset to be reciprocal of 2 times the time step: %f .\n", KiI, delt);
     parameters->KiI = 1.0/(2.0*delt);
   }
   if ((1.0/KiPLL) < 2.0*delt) {
     // write error message
-    sprintf(ErrorMessage, sizeof(ErrorMessage), "GFL-IBR Error - Parameter KiPLL is: %f, but has been reset to be reciprocal of 2 times the time step: %f .\n", KiPLL, delt);
+    snprintf(ErrorMessage, sizeof(ErrorMessage), "GFL-IBR Error - Parameter KiPLL is: %f, but has been reset to be reciprocal of 2 times the time step: %f .\n", KiPLL, delt);
     parameters->KiPLL = 1.0/(2.0*delt);
   }
   if ((1.0 / KiP) < 2.0 * delt) {
     // write error message
-    sprintf(ErrorMessage, sizeof(ErrorMessage), "GFL-IBR Error - Parameter KiP is: %f, but has been reset to be reciprocal of 2 times the time step: %f .\n", KiP, delt);
+    snprintf(ErrorMessage, sizeof(ErrorMessage), "GFL-IBR Error - Parameter KiP is: %f, but has been reset to be reciprocal of 2 times the time step: %f .\n", KiP, delt);
     parameters->KiP = 1.0 / (2.0 * delt);
   }
   if ((1.0 / KiQ) < 2.0 * delt) {
     // write error message
-    sprintf(ErrorMessage, sizeof(ErrorMessage), "GFL-IBR Error - Parameter KiQ is: %f, but has been reset to be reciprocal of 2 times the time step: %f .\n", KiQ, delt);
+    snprintf(ErrorMessage, sizeof(ErrorMessage), "GFL-IBR Error - Parameter KiQ is: %f, but has been reset to be reciprocal of 2 times the time step: %f .\n", KiQ, delt);
     parameters->KiQ = 1.0 / (2.0 * delt);
   }
   if ((1.0 / KiV) < 2.0 * delt) {
     // write error message
-    sprintf(ErrorMessage, sizeof(ErrorMessage), "GFL-IBR Error - Parameter KiV is: %f, but has been reset to be reciprocal of 2 times the time step: %f .\n", KiV, delt);
+    snprintf(ErrorMessage, sizeof(ErrorMessage), "GFL-IBR Error - Parameter KiV is: %f, but has been reset to be reciprocal of 2 times the time step: %f .\n", KiV, delt);
     parameters->KiV = 1.0 / (2.0 * delt);
   }
+  MODEL_TRACE_LOG(IEEE_Cigre_DLLInterface_Log_Debug, "Params: { KiI= %f, KiPLL= %f, KiP= %f, KiQ= %f, KiV= %f }\n", parameters->KiI, parameters->KiPLL, parameters->KiP, parameters->KiQ, parameters->KiV);
   instance->LastGeneralMessage = ErrorMessage;
   return IEEE_Cigre_DLLInterface_Return_OK;
 };
 
 // ----------------------------------------------------------------
-__declspec(dllexport) int32_T __cdecl Model_Initialize(IEEE_Cigre_DLLInterface_Instance* instance) {
+IEEE_Cigre_DLLInterface_EXPORT int32_T IEEE_Cigre_DLLInterface_CALL Model_Initialize(IEEE_Cigre_DLLInterface_Instance* instance) {
   /*   Initializes the system by resetting the internal states
       Arguments: Instance specific model structure containing Inputs, Parameters and Outputs
       Return:    Integer status 0 (normal), 1 if messages are written, 2 for errors.  See IEEE_Cigre_DLLInterface_types.h
@@ -1117,7 +1126,7 @@ double LEADLAG(double G, double T1, double T2, double x, double x_old, double y_
 
 
 // ----------------------------------------------------------------
-__declspec(dllexport) int32_T __cdecl Model_Outputs(IEEE_Cigre_DLLInterface_Instance* instance) {
+IEEE_Cigre_DLLInterface_EXPORT int32_T IEEE_Cigre_DLLInterface_CALL Model_Outputs(IEEE_Cigre_DLLInterface_Instance* instance) {
   /*   Calculates output equation
       Arguments: Instance specific model structure containing Inputs, Parameters and Outputs
       Return:    Integer status 0 (normal), 1 if messages are written, 2 for errors.  See IEEE_Cigre_DLLInterface_types.h
@@ -1513,7 +1522,7 @@ __declspec(dllexport) int32_T __cdecl Model_Outputs(IEEE_Cigre_DLLInterface_Inst
 };
 
 // ----------------------------------------------------------------
-__declspec(dllexport) int32_T __cdecl Model_Terminate(IEEE_Cigre_DLLInterface_Instance* instance) {
+IEEE_Cigre_DLLInterface_EXPORT int32_T IEEE_Cigre_DLLInterface_CALL Model_Terminate(IEEE_Cigre_DLLInterface_Instance* instance) {
   /*   Destroys any objects allocated by the model code - not used
   */
   ErrorMessage[0] = '\0';
@@ -1522,7 +1531,7 @@ __declspec(dllexport) int32_T __cdecl Model_Terminate(IEEE_Cigre_DLLInterface_In
   return IEEE_Cigre_DLLInterface_Return_OK;
 };
 // ----------------------------------------------------------------
-__declspec(dllexport) int32_T __cdecl Model_PrintInfo() {
+IEEE_Cigre_DLLInterface_EXPORT int32_T IEEE_Cigre_DLLInterface_CALL Model_PrintInfo() {
   /* Prints Model Information once
   */
   int k;
@@ -11,20 +11,74 @@ typedef IEEE_Cigre_DLLInterface_Model_Info* ( *GetInfo )( void );
 static GetInfo getInfo;
 
 
-void variablesNames( const char *label, int32_T size, IEEE_Cigre_DLLInterface_Model_Info *modelInfo, const char **namesVectors ) {
+// Array dimension of a signal, scalars may declare a 'Width' of 0 or 1
+int signalWidth( const IEEE_Cigre_DLLInterface_Signal *signal ) {
+  return ( signal -> Width > 1 ) ? signal -> Width : 1;
+}
+
+
+// Number of ATP values taken by the signals ( sum of their widths )
+int signalValues( const IEEE_Cigre_DLLInterface_Signal *signals, int size ) {
+
+  int i, values= 0;
+  for ( i= 0; i < size; i++ ) {
+    values += signalWidth( &signals[i] );
+  }
+
+  return values;
+}
+
+
+// 'xvar' slots taken by the model states, laid out as in dll_one ( buildStateLayout ): int and float states packed in
+// 4 bytes each, the double states from the next 8-byte boundary
+int stateSlots( int sizeNumIntStates, int sizeNumFloatStates, int sizeNumDoubleStates ) {
+
+  int bytes= 4 * ( sizeNumIntStates + sizeNumFloatStates );
+  bytes= ( bytes + 7 ) & ~7;
+  bytes += 8 * sizeNumDoubleStates;
+
+  return ( bytes + 7 ) / 8;
+}
+
+
+// Names of the MODELS variables, 'suffix' is appended to the name and array ports are declared as 'name<suffix>[1..Width]'
+void variablesNames( const char *label, int32_T size, IEEE_Cigre_DLLInterface_Model_Info *modelInfo, const char *suffix, const char **namesVectors ) {
 
   int i;
   for ( i= 0; i < size; i++ ) {
 
+    const char *name= "";
+    int width= 1;
+
     if ( strcmp( label, "Inputs" ) == 0 ) {            
-      namesVectors[i]= modelInfo -> InputPortsInfo[i].Name;  
+      name= modelInfo -> InputPortsInfo[i].Name;  
+      width= signalWidth( &modelInfo -> InputPortsInfo[i] );
     } else if ( strcmp( label, "Outputs" ) == 0 ) {
-      namesVectors[i]= modelInfo -> OutputPortsInfo[i].Name;   
+      name= modelInfo -> OutputPortsInfo[i].Name;   
+      width= signalWidth( &modelInfo -> OutputPortsInfo[i] );
     } else if ( strcmp( label, "Parameters" ) == 0 ) {
-      namesVectors[i]= modelInfo -> ParametersInfo[i].Name;           
+      name= modelInfo -> ParametersInfo[i].Name;           
+    }
+
+    char *decorated= malloc( strlen( name ) + strlen( suffix ) + 32 );
+    if ( width > 1 ) {
+      sprintf( decorated, "%s%s[1..%i]", name, suffix, width );
+    } else {
+      sprintf( decorated, "%s%s", name, suffix );
     }
+    namesVectors[i]= decorated;
+
+  }
+}
 
+
+void freeNames( const char **namesVectors, int size ) {
+
+  int i;
+  for ( i= 0; i < size; i++ ) {
+    free( ( char * ) namesVectors[i] );
   }
+  free( namesVectors );
 }
 
 
@@ -50,7 +104,7 @@ void appendSection( char **buffer, const char *sectionTitle, const char **names,
 }
 
 
-void inputSection( char **blueprint, int sizeInputs, const char **namesInputs, int sizeOutputs, const char **namesOutputs ) {
+void inputSection( char **blueprint, int sizeInputs, const char **namesInputs, int sizeOutputs, const char **namesOutputs0 ) {
   
   strcat( *blueprint, "  INPUT\n" );
 
@@ -71,7 +125,7 @@ void inputSection( char **blueprint, int sizeInputs, const char **namesInputs, i
   for ( i= 0; i < sizeOutputs; i++ ) {
 
     if ( i == 0 ) strcat( outInit, "\n    " );
-    sprintf( out_init, "%s_0", namesOutputs[i] );
+    sprintf( out_init, "%s", namesOutputs0[i] );
     if ( i != sizeOutputs - 1 ) strcat( out_init, ", " );
     strcat( outInit, out_init );
 
@@ -86,9 +140,12 @@ void inputSection( char **blueprint, int sizeInputs, const char **namesInputs, i
 
 void initSection( char **blueprint, 
                   int sizeInputs, 
+                  int valuesInputs, 
                   const char **namesInputs, 
                   int sizeOutputs, 
+                  int valuesOutputs, 
                   const char **namesOutputs, 
+                  const char **namesOutputs0, 
                   int sizeParams, 
                   const char **namesParams, 
                   char *inputsFromATP, 
@@ -106,7 +163,7 @@ void initSection( char **blueprint,
   // Initializing the outpus variables with the output's init values
   int i;
   for ( i= 0; i < sizeOutputs; i++ ) {
-    sprintf( _init, "    %s:= %s_0 \n", namesOutputs[i], namesOutputs[i] );
+    sprintf( _init, "    %s:= %s \n", namesOutputs[i], namesOutputs0[i] );
     strcat( outInit, _init );
   }
 
@@ -122,7 +179,7 @@ void initSection( char **blueprint,
     }
   }
   
-  sprintf( _init, ( sizeInputs > 1 ? "    %s:= [ %s ]\n": "    %s:= %s\n" ), inputsFromATP, inputs_init );
+  sprintf( _init, ( valuesInputs > 1 ? "    %s:= [ %s ]\n": "    %s:= %s\n" ), inputsFromATP, inputs_init );
   strcat( outInit, _init );
 
 
@@ -147,14 +204,14 @@ void initSection( char **blueprint,
   outputs_init[0]= '\0';
 
   for ( i= 0; i < sizeOutputs; i++ ) {
-    sprintf( _init, "%s_0", namesOutputs[i] );
+    sprintf( _init, "%s", namesOutputs0[i] );
     strcat( outputs_init, _init );
     if ( i != sizeOutputs - 1 ) {
       strcat( outputs_init, ", " );
     }
   }
 
-  sprintf( _init, ( sizeOutputs > 1 ? "    %s:= [ %s ]\n": "    %s:= %s\n" ), outputsInit, outputs_init );
+  sprintf( _init, ( valuesOutputs > 1 ? "    %s:= [ %s ]\n": "    %s:= %s\n" ), outputsInit, outputs_init );
   strcat( outInit, _init );
   
   strcat( *blueprint, outInit );  
@@ -165,12 +222,13 @@ void initSection( char **blueprint,
 }
 
 
-void fgnSection( char **blueprint, const char *modelName, int sizeInputs, int sizeOutputs, int sizeParams, int sizeNumIntStates, int sizeNumFloatStates, int sizeNumDoubleStates ) {
+void fgnSection( char **blueprint, const char *modelName, int valuesInputs, int valuesOutputs, int sizeParams, int sizeNumIntStates, int sizeNumFloatStates, int sizeNumDoubleStates ) {
   
   char *fgnSec= malloc( 512 );
   fgnSec[0]= '\0';
 
-  sprintf( fgnSec, "MODEL %s_dll FOREIGN dll_one { ixdata: %i, ixin: %i, ixout: %i, ixvar: %i }\n", modelName, ( sizeParams + 2 ), ( sizeInputs + 2 ), sizeOutputs, ( sizeNumIntStates + sizeNumFloatStates + sizeNumDoubleStates ) );
+  // 'ixin' and 'ixout' count array ports once per element, 'ixvar' holds the packed model states
+  sprintf( fgnSec, "MODEL %s_dll FOREIGN dll_one { ixdata: %i, ixin: %i, ixout: %i, ixvar: %i }\n", modelName, ( sizeParams + 3 ), ( valuesInputs + valuesOutputs + 1 ), valuesOutputs, stateSlots( sizeNumIntStates, sizeNumFloatStates, sizeNumDoubleStates ) );
   appendSection( blueprint, 0, ( const char ** )&fgnSec, 1 );   
 
   free( fgnSec );
@@ -180,14 +238,18 @@ void fgnSection( char **blueprint, const char *modelName, int sizeInputs, int si
 void execSection( char **blueprint, 
                   const char *modelName, 
                   int sizeInputs, 
+                  int valuesInputs, 
                   const char **namesInputs, 
                   int sizeOutputs, 
+                  int valuesOutputs, 
                   const char **namesOutputs, 
+                  const char **namesOutputs0, 
                   int sizeParams, 
                   const char **namesParams, 
                   char *inputsFromATP, 
                   char *paramsFromATP, 
-                  char *outputsInit ) {
+                  char *outputsInit, 
+                  const IEEE_Cigre_DLLInterface_Signal *outputsInfo ) {
 
   strcat( *blueprint, "  EXEC\n" );
 
@@ -206,21 +268,21 @@ void execSection( char **blueprint,
     }
   }
   
-  sprintf( exec_aux, ( sizeInputs > 1 ? "    %s:= [ %s ]\n": "    %s:= %s\n" ), inputsFromATP, exec_sec );
+  sprintf( exec_aux, ( valuesInputs > 1 ? "    %s:= [ %s ]\n": "    %s:= %s\n" ), inputsFromATP, exec_sec );
   strcat( execSec, exec_aux );
 
 
   // Assigning the outputs values to the 'outputsInit' variable
   exec_sec[0]= '\0';
   for ( i= 0; i < sizeOutputs; i++ ) {
-    sprintf( exec_aux, "%s", namesOutputs[i] );
+    sprintf( exec_aux, "%s", namesOutputs0[i] );
     strcat( exec_sec, exec_aux );
     if ( i != sizeOutputs - 1 ) {
       strcat( exec_sec, ", " );
     }
   }
 
-  sprintf( exec_aux, ( sizeOutputs > 1 ? "    %s:= [ %s_0 ]\n": "    %s:= %s_0\n" ), outputsInit, exec_sec );
+  sprintf( exec_aux, ( valuesOutputs > 1 ? "    %s:= [ %s ]\n": "    %s:= %s\n" ), outputsInit, exec_sec );
   strcat( execSec, exec_aux );
 
 
@@ -232,20 +294,27 @@ void execSection( char **blueprint,
 
     // DATA
   strcat( execSec, "      DATA\n" );
-  sprintf( exec_sec, "        xdata[1..%i]:= [ %s, timestep, TRelease ]\n\n", ( sizeParams > 1 ? ( sizeParams + 2 ) : 3 ), paramsFromATP );
+  sprintf( exec_sec, "        xdata[1..%i]:= [ dllIndex, %s, timestep, TRelease ]\n\n", ( sizeParams + 3 ), paramsFromATP );
   strcat( execSec, exec_sec );
 
     // INPUT
   strcat( execSec, "      INPUT\n" );
-  sprintf( exec_sec, "        xin[1..%i]:= [ %s, %s, t ]\n\n", ( sizeInputs > 1 ? ( sizeInputs + sizeOutputs + 1 ) : 1 ), inputsFromATP, outputsInit );
+  sprintf( exec_sec, "        xin[1..%i]:= [ %s, %s, t ]\n\n", ( valuesInputs + valuesOutputs + 1 ), inputsFromATP, outputsInit );
   strcat( execSec, exec_sec );
 
     // OUTPUT
   strcat( execSec, "      OUTPUT\n" );
-  if ( sizeOutputs > 1 ) {
+  if ( valuesOutputs > 1 ) {
+    int first= 1;                                                                             // Array ports take 'Width' consecutive 'xout' values
     for ( i= 0; i < sizeOutputs; i++ ) {
-      sprintf( exec_aux, "        %s:= xout[%i]\n", namesOutputs[i], ( i + 1 ) );
+      int width= signalWidth( &outputsInfo[i] );
+      if ( width > 1 ) {
+        sprintf( exec_aux, "        %s:= xout[%i..%i]\n", namesOutputs[i], first, ( first + width - 1 ) );
+      } else {
+        sprintf( exec_aux, "        %s:= xout[%i]\n", namesOutputs[i], first );
+      }
       strcat( execSec, exec_aux );
+      first += width;
     }
   } else {
     sprintf( exec_aux, "        %s:= xout\n", namesOutputs[0] );
@@ -344,14 +413,20 @@ char* modelBlueprint( IEEE_Cigre_DLLInterface_Model_Info *modelInfo ) {
   int sizeNumFloatStates= modelInfo -> NumFloatStates;
   int sizeNumDoubleStates= modelInfo -> NumDoubleStates;
 
+  int valuesInputs= signalValues( modelInfo -> InputPortsInfo, sizeInputs );
+  int valuesOutputs= signalValues( modelInfo -> OutputPortsInfo, sizeOutputs );
+
   const char **namesInputs= malloc( sizeInputs * sizeof( const char * ) );
-  variablesNames( "Inputs", sizeInputs, modelInfo, namesInputs );
+  variablesNames( "Inputs", sizeInputs, modelInfo, "", namesInputs );
 
   const char **namesOutputs= malloc( sizeOutputs * sizeof( const char * ) );
-  variablesNames( "Outputs", sizeOutputs, modelInfo, namesOutputs );
+  variablesNames( "Outputs", sizeOutputs, modelInfo, "", namesOutputs );
+
+  const char **namesOutputs0= malloc( sizeOutputs * sizeof( const char * ) );
+  variablesNames( "Outputs", sizeOutputs, modelInfo, "_0", namesOutputs0 );
 
   const char **namesParams= malloc( sizeParams * sizeof( const char * ) );
-  variablesNames( "Parameters", sizeParams, modelInfo, namesParams );
+  variablesNames( "Parameters", sizeParams, modelInfo, "", namesParams );
 
 
 
@@ -385,10 +460,11 @@ char* modelBlueprint( IEEE_Cigre_DLLInterface_Model_Info *modelInfo ) {
   defaultParameters( modelInfo, sizeParams, dfltPrmSec );
   strcat( blueprint, dfltPrmSec );
   strcat( blueprint, "    TRelease { DFLT: 0 }\n" );
+  strcat( blueprint, "    dllIndex { DFLT: 1 }\n" );                                  // Line of the dll in the dll_one dll list
   strcat( blueprint, "\n" );
 
   // INPUTS
-  inputSection( &blueprint, sizeInputs, namesInputs, sizeOutputs, namesOutputs );
+  inputSection( &blueprint, sizeInputs, namesInputs, sizeOutputs, namesOutputs0 );
 
   // OUTPUTS
   appendSection( &blueprint, "  OUTPUT", namesOutputs, sizeOutputs );
@@ -407,8 +483,8 @@ char* modelBlueprint( IEEE_Cigre_DLLInterface_Model_Info *modelInfo ) {
   char var_line[512];
   
   strcpy( inputsFromATP, "inputsFromATP" );
-  if ( sizeInputs > 1 ) {
-    sprintf( var_line, "[1..%i]", sizeInputs );
+  if ( valuesInputs > 1 ) {
+    sprintf( var_line, "[1..%i]", valuesInputs );
     strcat( inputsFromATP, var_line );
   }
 
@@ -419,8 +495,8 @@ char* modelBlueprint( IEEE_Cigre_DLLInterface_Model_Info *modelInfo ) {
   }
   
   strcpy( outputsInit, "outputsInit" );
-  if ( sizeOutputs > 1 ) {
-    sprintf( var_line, "[1..%i]", sizeOutputs );
+  if ( valuesOutputs > 1 ) {
+    sprintf( var_line, "[1..%i]", valuesOutputs );
     strcat( outputsInit, var_line );
   }
 
@@ -428,20 +504,21 @@ char* modelBlueprint( IEEE_Cigre_DLLInterface_Model_Info *modelInfo ) {
   appendSection( &blueprint, 0, ( const char ** )&varLine, 1 );
 
   // INIT
-  initSection( &blueprint, sizeInputs, namesInputs, sizeOutputs, namesOutputs, sizeParams, namesParams, inputsFromATP, paramsFromATP, outputsInit );
+  initSection( &blueprint, sizeInputs, valuesInputs, namesInputs, sizeOutputs, valuesOutputs, namesOutputs, namesOutputs0, sizeParams, namesParams, inputsFromATP, paramsFromATP, outputsInit );
 
   // Load the DLL 
-  fgnSection( &blueprint, modelName, sizeInputs, sizeOutputs, sizeParams, sizeNumIntStates, sizeNumFloatStates, sizeNumDoubleStates );
+  fgnSection( &blueprint, modelName, valuesInputs, valuesOutputs, sizeParams, sizeNumIntStates, sizeNumFloatStates, sizeNumDoubleStates );
 
   // EXEC
-  execSection( &blueprint, modelName, sizeInputs, namesInputs, sizeOutputs, namesOutputs, sizeParams, namesParams, inputsFromATP, paramsFromATP, outputsInit );
+  execSection( &blueprint, modelName, sizeInputs, valuesInputs, namesInputs, sizeOutputs, valuesOutputs, namesOutputs, namesOutputs0, sizeParams, namesParams, inputsFromATP, paramsFromATP, outputsInit, modelInfo -> OutputPortsInfo );
 
   strcat( blueprint, "ENDMODEL\n" );
 
   free( dfltPrmSec );  
-  free( namesInputs );
-  free( namesOutputs );
-  free( namesParams );  
+  freeNames( namesInputs, sizeInputs );
+  freeNames( namesOutputs, sizeOutputs );
+  freeNames( namesOutputs0, sizeOutputs );
+  freeNames( namesParams, sizeParams );  
 
   return blueprint;
 }
@@ -47,8 +47,22 @@ szIntSt= modelInfo.NumIntStates
 szFlSt= modelInfo.NumFloatStates
 szDbSt= modelInfo.NumDoubleStates
 
-namesInputs= [ modelInfo.InputPortsInfo[i].Name.decode() for i in range( szI ) ]
-namesOutputs= [ modelInfo.OutputPortsInfo[i].Name.decode() for i in range( szO ) ]
+# 'xvar' slots of the states, as laid out by dll_one: int and float states in 4 bytes each, doubles from the next 8-byte boundary
+stateSlots= ( ( ( 4 * ( szIntSt + szFlSt ) + 7 ) // 8 * 8 ) + 8 * szDbSt + 7 ) // 8
+
+# Array ports declare 'Width' > 1, scalars may declare 0 or 1
+widthsInputs= [ max( modelInfo.InputPortsInfo[i].Width, 1 ) for i in range( szI ) ]
+widthsOutputs= [ max( modelInfo.OutputPortsInfo[i].Width, 1 ) for i in range( szO ) ]
+valI= sum( widthsInputs )
+valO= sum( widthsOutputs )
+
+def arrayName( name, width, suffix= "" ):
+  return f"{ name }{ suffix }[1..{ width }]" if width > 1 else f"{ name }{ suffix }"
+
+namesInputs= [ arrayName( modelInfo.InputPortsInfo[i].Name.decode(), widthsInputs[i] ) for i in range( szI ) ]
+namesOutputs= [ arrayName( modelInfo.OutputPortsInfo[i].Name.decode(), widthsOutputs[i] ) for i in range( szO ) ]
+namesOutputs0= [ arrayName( modelInfo.OutputPortsInfo[i].Name.decode(), widthsOutputs[i], "_0" ) for i in range( szO ) ]
+firstOutputs= [ 1 + sum( widthsOutputs[:i] ) for i in range( szO ) ]
 namesParams= [ modelInfo.ParametersInfo[i].Name.decode() for i in range( szP ) ]
 print( f"NamesInputs= { namesInputs }" )
 print( f"NameOutputs= { namesOutputs }" )
@@ -91,43 +105,44 @@ MODELS { modelName }
   DATA
     { '\n    '.join( [ defaultParameters( modelInfo, namesParams, i ) for i in range( szP ) ] ) }
     TRelease {{ DFLT: 0 }}
+    dllIndex {{ DFLT: 1 }}
 
   INPUT
     { ( ", ".join( namesInputs ) if szI >= 1 else "" ) }
-    { ( "_0, ".join( namesOutputs ) if szO >= 1 else "" ) }{ "_0" if szO >= 1 else "" }
+    { ( ", ".join( namesOutputs0 ) if szO >= 1 else "" ) }
 
   OUTPUT
     { ( ", ".join( namesOutputs ) if szO >= 1 else "" ) }
 
   VAR
     { ( ", ".join( namesOutputs ) if szO >= 1 else "" ) }
-    { "inputsFromATP" if szI >= 1 else "" }{ ( f"[1..{ szI }]" if szI > 1 else "" ) }, { "paramsFromATP" if szP >= 1 else "" }{ ( f"[1..{ szP }]" if szP > 1 else "" ) }, { "outputsInit" if szO >= 1 else "" }{ ( f"[1..{ szO }]" if szO > 1 else "" ) }
+    { "inputsFromATP" if szI >= 1 else "" }{ ( f"[1..{ valI }]" if valI > 1 else "" ) }, { "paramsFromATP" if szP >= 1 else "" }{ ( f"[1..{ szP }]" if szP > 1 else "" ) }, { "outputsInit" if szO >= 1 else "" }{ ( f"[1..{ valO }]" if valO > 1 else "" ) }
 
   INIT
-    { '\n    '.join( f"{ i }:= { i }_0" for i in namesInputs ) }
-    { "inputsFromATP" if szI >= 1 else "" }{ ( f"[1..{ szI }]" if szI > 1 else "" ) }:= { ( f"[ { ", ".join( namesInputs ) } ] " if szI > 1 else f"{ namesParams[0] }" ) }
+    { '\n    '.join( f"{ i }:= { j }" for i,j in zip( namesOutputs, namesOutputs0 ) ) }
+    { "inputsFromATP" if szI >= 1 else "" }{ ( f"[1..{ valI }]" if valI > 1 else "" ) }:= { ( f"[ { ", ".join( namesInputs ) } ] " if valI > 1 else f"{ namesInputs[0] }" ) }
     { "paramsFromATP" if szP >= 1 else "" }{ ( f"[1..{ szP }]" if szP > 1 else "" ) }:= { ( f"[ { ", ".join( namesParams ) } ] " if szP > 1 else f"{ namesParams[0] }" ) }
-    { "outputsInit" if szO >= 1 else "" }{ ( f"[1..{ szO }]" if szO > 1 else "" ) }:= { ( f"[ { '_0, '.join( namesOutputs ) }_0 ] " if szO > 1 else f"{ namesOutputs[0] }_0" ) }
+    { "outputsInit" if szO >= 1 else "" }{ ( f"[1..{ valO }]" if valO > 1 else "" ) }:= { ( f"[ { ', '.join( namesOutputs0 ) } ] " if valO > 1 else f"{ namesOutputs0[0] }" ) }
 
   ENDINIT
 
-  MODEL { modelName }_dll FOREIGN dll_one {{ ixdata: { szP + 2 }, ixin: { szI + szO + 1 }, ixout: { szO }, ixvar: { szIntSt + szFlSt + szDbSt } }}
+  MODEL { modelName }_dll FOREIGN dll_one {{ ixdata: { szP + 3 }, ixin: { valI + valO + 1 }, ixout: { valO }, ixvar: { stateSlots } }}
 
   EXEC
 
-    { "inputsFromATP" if szI >= 1 else "" }{ ( f"[1..{ szI }]" if szI > 1 else "" ) }:= { ( f"[ { ", ".join( namesInputs ) } ] " if szI > 1 else f"{ namesParams[0] }" ) }
-    { "outputsInit" if szO >= 1 else "" }{ ( f"[1..{ szO }]" if szO > 1 else "" ) }:= { ( f"[ { '_0, '.join( namesOutputs ) }_0 ] " if szO > 1 else f"{ namesOutputs[0] }_0" ) }
+    { "inputsFromATP" if szI >= 1 else "" }{ ( f"[1..{ valI }]" if valI > 1 else "" ) }:= { ( f"[ { ", ".join( namesInputs ) } ] " if valI > 1 else f"{ namesInputs[0] }" ) }
+    { "outputsInit" if szO >= 1 else "" }{ ( f"[1..{ valO }]" if valO > 1 else "" ) }:= { ( f"[ { ', '.join( namesOutputs0 ) } ] " if valO > 1 else f"{ namesOutputs0[0] }" ) }
 
     USE { modelName }_dll AS { modelName }_dll
 
       DATA
-        xdata{ ( f"[1..{ szP + 2 }]" if szP >= 1 else "2" ) }:= [{ ( " paramsFromATP" if szP >= 1 else "" ) }{ ( f"[1..{ szP }]" if szP > 1 else "" ) }{ ( ", " if szP >= 1 else "" ) } timestep, TRelease ]
+        xdata[1..{ szP + 3 }]:= [ dllIndex,{ ( " paramsFromATP" if szP >= 1 else "" ) }{ ( f"[1..{ szP }]" if szP > 1 else "" ) }{ ( ", " if szP >= 1 else "" ) } timestep, TRelease ]
 
       INPUT
-        xin{ ( f"[1..{ szI + szO + 1 }]" if ( szI >= 1 or szO >= 1) else "2" ) }:= [{ ( " inputsFromATP" if szI >= 1 else "" ) }{ ( f"[1..{ szI }]" if szI > 1 else "" ) }{ ( ", " if szI >= 1 else "" ) }{ ( " outputsInit" if szO >= 1 else "" ) }{ ( f"[1..{ szO }]" if szO > 1 else "" ) }{ ( ", " if szO >= 1 else "" ) } t ]   
+        xin{ ( f"[1..{ valI + valO + 1 }]" if ( szI >= 1 or szO >= 1) else "2" ) }:= [{ ( " inputsFromATP" if szI >= 1 else "" ) }{ ( f"[1..{ valI }]" if valI > 1 else "" ) }{ ( ", " if szI >= 1 else "" ) }{ ( " outputsInit" if szO >= 1 else "" ) }{ ( f"[1..{ valO }]" if valO > 1 else "" ) }{ ( ", " if szO >= 1 else "" ) } t ]   
 
       OUTPUT
-        { ( '\n        '.join( f"{ i }:= xout[{ k + 1 }]" for k,i in enumerate( namesOutputs ) ) if szO > 1 else ( f"{ namesOutputs[0] }:= xout" if szO == 1 else "" ) ) }
+        { ( '\n        '.join( ( f"{ i }:= xout[{ f }..{ f + w - 1 }]" if w > 1 else f"{ i }:= xout[{ f }]" ) for i,f,w in zip( namesOutputs, firstOutputs, widthsOutputs ) ) if valO > 1 else ( f"{ namesOutputs[0] }:= xout" if szO == 1 else "" ) ) }
 
     ENDUSE
 
@@ -1,343 +1,1392 @@
-#include <stdio.h>    // needed for printLIS_
+#include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <stdint.h>
 #include <stdarg.h>
-#include <windows.h>
+#include <math.h>
 #include "IEEE_Cigre_DLLInterface.h"
+#define IEEE_Cigre_DLLInterface_Log_Host                                      // Only the sink types, not the model helpers
+#include "IEEE_Cigre_DLLInterface_Log.h"
+#include "dll_one_layout.h"
+#include "dll_one_arena.h"
+#include "dll_one_log.h"
+#include "dll_one_loader.h"
+#include "dll_one_host.h"
+#include "dll_one_record.h"
 
 
-static HMODULE hDLL = NULL;
-static IEEE_Cigre_DLLInterface_Instance *ptr_toModel= NULL;
-static FILE *pFile= NULL;
+#define XDATA_DLL_INDEX 0                                                     // 'xdata' slot selecting the dll in the dll list ( 1-based line number )
+#define XDATA_PARAMS 1                                                        // First 'xdata' slot holding the model parameters
 
-static real64_T timeStep= 0;
-static real64_T timeStepDLL= 0;
-static real64_T nextTimeStepDLL= 0;
-static real64_T TRelease= 0;
+#define DLL_LIST_ENV "DLL_ONE_LIST"                                           // Environment variable with the location of the dll list
+#define DLL_LIST_DEFAULT "dll_list.txt"                                       // Dll list used when the variable is not set
+#define DLL_LIST_OPTIONS '|'                                                  // Separates the dll path from the options of its line ( 'rms=', 'tol=' )
 
-static int32_T sizeInputs= 0;
-static int32_T sizeOutputs= 0;
-static int32_T sizeParams= 0; 
+#define TERMINATE_ENV "DLL_ONE_TERMINATE"                                     // Call Model_Terminate and report at process exit when > 0 ( ATP has no end-of-simulation call )
+
+#define RMS_ITERATIONS_ENV "DLL_ONE_RMS_ITERATIONS"                           // Default Model_Iterate calls after each Model_Outputs, RMS mode when > 0 ( 'rms=' in the dll list )
+#define RMS_TOLERANCE_ENV "DLL_ONE_RMS_TOLERANCE"                             // Default output change ( relative to max( 1, |output| ) ) that ends the iterations early ( 'tol=' )
+
+#define SETTLE_STEPS_ENV "DLL_ONE_SETTLE_STEPS"                               // Model_Outputs calls allowed to settle the model in 'dll_one_i', off when 0
+#define SETTLE_TOLERANCE_ENV "DLL_ONE_SETTLE_TOL"                             // Double state change ( relative to max( 1, |state| ) ) considered settled
+
+#define CHECKPOINT_ENV "DLL_ONE_CHECKPOINT"                                   // Path prefix of the instance checkpoints ( '<prefix>_<dllIndex>_<order>.chk' ), off when not set
+#define CHECKPOINT_TIME_ENV "DLL_ONE_CHECKPOINT_TIME"                         // Simulation time the checkpoints are saved at ( default: end of 'dll_one_i' )
+#define CHECKPOINT_MAGIC "DLL2CHK"
+
+#define FNV_OFFSET_BASIS 14695981039346656037ULL
+#define FNV_PRIME 1099511628211ULL
+
+#define RECORD_ENV "DLL_ONE_RECORD"                                           // Path prefix of the I/O records ( '<prefix>_<handle>.rec' ), off when not set
+#define RECORD_INSTANCES_ENV "DLL_ONE_RECORD_INSTANCES"                       // Comma-separated handles of the recorded instances ( default: every instance )
+
+#define MESSAGE_CAP_ENV "DLL_ONE_MESSAGE_CAP"                                 // Distinct general messages tracked ( and printed ) per instance
+#define MESSAGE_CAP_DEFAULT 16
+#define MESSAGE_TEXT 120                                                      // Bytes of a message kept for the report
+
+#define RATE_WHEEL_SLOTS 64                                                   // Slots of the timing wheel, one per ATP step modulo the size
 
-static int32_T *inputsTypes= NULL;  
-static size_t *inputsOffsets= NULL;
-static int32_T *outputsTypes= NULL;
-static size_t *outputsOffsets= NULL; 
 
 typedef int32_T ( *PrintInfo )( void ); 
-typedef IEEE_Cigre_DLLInterface_Model_Info* ( *GetInfo )( void );
-typedef int32_T ( *ModelFirstCall )( IEEE_Cigre_DLLInterface_Instance* instance );
-typedef int32_T ( *CheckParameters )( IEEE_Cigre_DLLInterface_Instance* instance ); 
-typedef int32_T ( *ModelInitialize )( IEEE_Cigre_DLLInterface_Instance* instance ); 
-typedef int32_T ( *ModelOutputs )( IEEE_Cigre_DLLInterface_Instance* instance ); 
-typedef int32_T ( *ModelIterate )( IEEE_Cigre_DLLInterface_Instance* instance );
-typedef int32_T ( *ModelTerminate )( IEEE_Cigre_DLLInterface_Instance* instance );
-static ModelOutputs modelOutputs;
-static ModelInitialize modelInitialize;
+
+
+// One loaded model dll, shared by every instance created from it
+typedef struct _DllModule {
+  char path[ MAX_PATH ];                                                      // Dll list name that loaded it first
+  HMODULE hDLL;                                                               // Key of the registry
+  int32_T refCount;
+
+  IEEE_Cigre_DLLInterface_Model_Info *modelInfo;
+
+  DllModelEntries entries;                                                    // Entry points ( dll_one_host.h )
+
+  DllPortLayout inputs;                                                       // Port layouts and conversion plans, read-only once built
+  DllPortLayout params;
+  DllPortLayout outputs;
+  DllStateLayout states;                                                      // Byte layout of the states in 'xvar'
+
+  void *paramsScratch;                                                        // Private parameter block of the instance being initialized
+  struct _DllParamBlock *paramBlocks;                                         // Interned parameter blocks of the instances
+
+  struct _DllModule *next;
+} DllModule;
+
+// One line of the dll list: the dll and the execution options of the instances that select it
+typedef struct _DllListEntry {
+  char *path;
+  int32_T rmsIterations;                                                      // 'rms=', < 0 when not given ( DLL_ONE_RMS_ITERATIONS )
+  real64_T rmsTolerance;                                                      // 'tol=', < 0 when not given ( DLL_ONE_RMS_TOLERANCE )
+} DllListEntry;
+
+// Parameter block shared by every instance of a module with the same parameters, read-only once interned
+typedef struct _DllParamBlock {
+  uint64_t hash;                                                              // FNV-1a of the block
+  void *values;                                                               // 'params.totalSize' bytes
+  int32_T refCount;
+
+  struct _DllParamBlock *next;
+} DllParamBlock;
+
+// Instances called every 'period' ATP steps, they are all due on the same steps
+typedef struct _RateGroup {
+  struct _RateClock *clock;                                                   // Counts the ATP steps of its 'timeStep'
+  int32_T period;
+  int32_T phase;                                                              // ATP steps from the first step of a data case to the first due step
+  int64_t nextTick;                                                           // Next ATP step the group is due
+  int64_t dueTick;                                                            // Last ATP step the group was due
+
+  struct _RateGroup *nextInSlot;                                              // Groups sharing a slot of the timing wheel
+  struct _RateGroup *next;
+} RateGroup;
+
+// ATP step counter and timing wheel of the instances with one 'timeStep': a MODELS block with its own time step
+// advances its own counter, so a step of one block never counts as a step of another
+typedef struct _RateClock {
+  real64_T timeStep;
+  int64_t tick;                                                               // Current ATP step, -1 before the first
+  real64_T tickTime;                                                          // Simulation time of 'tick'
+  int32_T restart;                                                            // 'dll_one_i' ran after the stepping started: a new data case
+
+  RateGroup *groups;
+  RateGroup *wheel[ RATE_WHEEL_SLOTS ];
+  struct _RateClock *next;
+} RateClock;
+
+// Header of a checkpoint file, followed by the int, float and double states, the outputs buffer and, when subcycling,
+// the ATP inputs of the last step
+typedef struct _DllCheckpointHeader {
+  char magic[8];
+  uint64_t paramsHash;                                                        // FNV-1a of the model name and the marshalled parameters
+  int32_T numIntStates;
+  int32_T numFloatStates;
+  int32_T numDoubleStates;
+  int32_T outputsSize;                                                        // Bytes of the outputs buffer
+  int32_T ticksPerCall;
+  int32_T subSteps;
+  int32_T nextCall;                                                           // ATP steps from 'time' to the next model call
+  int32_T numPrevInputs;                                                      // Subcycling: values of 'prevInputs', 0 otherwise
+  real64_T time;                                                              // Model time of the checkpoint, a restored model carries on from it
+} DllCheckpointHeader;
+
+// One distinct general message of an instance: printed the first time, counted afterwards
+typedef struct _DllMessageCount {
+  uint64_t hash;                                                              // FNV-1a of the message
+  int32_T count;
+  real64_T firstTime;
+  real64_T lastTime;
+  char text[ MESSAGE_TEXT ];                                                  // Start of the message, for the report
+} DllMessageCount;
+
+// Everything one 'USE ... FOREIGN dll_one' needs between calls
+typedef struct _DllInstance {
+  int32_T handle;                                                             // Initialization order, 1-based
+  int32_T dllIndex;                                                           // Line of its dll in the dll list
+  int32_T dllOrder;                                                           // Initialization order among the instances of its dll, 1-based
+  const double *xdata;                                                        // 'xdata' of the USE, ATP passes the same array at every call
+  DllModule *module;
+  IEEE_Cigre_DLLInterface_Instance *ptr_toModel;
+
+  real64_T timeStep;
+  real64_T timeStepDLL;
+  real64_T TRelease;
+  real64_T startTime;                                                         // Simulation time of 'dll_one_i'
+  real64_T timeOffset;                                                        // Model 'Time' minus the ATP time, the saved time of a restored checkpoint
+
+  int32_T ticksPerCall;                                                       // ATP steps between two model calls ( 'timeStepDLL' / 'timeStep' )
+  RateGroup *rateGroup;                                                       // Instances sharing 'timeStep' and 'ticksPerCall'
+  int64_t lastTick;                                                           // Last ATP step the model was called on, ATP may call twice at the same time
+  int32_T subSteps;                                                           // Model calls per ATP step when 'timeStepDLL' < 'timeStep' ( subcycling ), 1 otherwise
+
+  int32_T rmsIterations;                                                      // RMS mode when > 0: Model_Iterate calls after each Model_Outputs
+  real64_T rmsTolerance;
+  double *rmsOutputs;                                                         // RMS mode: outputs before the last Model_Iterate call
+
+  void *heldInputs;                                                           // Hold: marshalled inputs of the last Model_Initialize ( 'inputs.totalSize' bytes )
+  int32_T heldValid;                                                          // Hold: 'heldInputs' filled
+  double *initialOutputs;                                                     // Hold: initial outputs from ATP, returned until 'TRelease'
+
+  int32_T checkpointPending;                                                  // Checkpoint still to be saved at 'checkpointTime'
+
+  double *prevInputs;                                                         // Subcycling: ATP inputs of the previous step
+  double *subInputs;                                                          // Subcycling: inputs interpolated for the current model call
+
+  int32_T timeIndex;                                                          // Position of the simulation time in 'xin' ( after the input and initial output values )
+
+  const DllPortLayout *inputs;                                                // Port layouts and conversion plans, shared with the module
+  const DllPortLayout *params;
+  const DllPortLayout *outputs;
+
+  void *inputsBuffer;                                                         // Buffers owned by the wrapper, the model may point at the ATP arrays instead ( zero-copy layouts )
+  void *outputsBuffer;
+
+  DllRecorder *recorder;                                                      // I/O record of every model call, NULL when not recorded
+  uint8_T *statesBase;                                                        // Packed states in 'xvar' ( DllStateLayout )
+
+  DllMessageCount *messages;                                                  // General messages seen so far ( 'messageCap' entries ), heap, NULL until the first one
+  int32_T numMessages;
+  int32_T otherMessages;                                                      // Messages past the cap, counted only
+} DllInstance;
+
+// Instance table in initialization order, searched by 'xdata' from the instance after the last one found
+static DllInstance **instances= NULL;
+static int32_T numInstances= 0;
+static int32_T capInstances= 0;
+static int32_T lastFound= 0;
+
+// Exit handler registered with the first instance: 'dll_one_t__' with DLL_ONE_TERMINATE, 'closeRecorders' otherwise
+static int32_T exitHandler= 0;
+
+// Every instance is carved from here while 'dll_one_i' runs: its context, model instance, layouts and buffers form one slab
+static DllArena instanceArena;
+
+// Module registry and the dll list it is loaded from, both read once per process
+static DllModule *modules= NULL;
+static DllListEntry *dllList= NULL;
+static int32_T numDlls= 0;
+
+// One step counter per ATP time step, each with its rate groups and the timing wheel that marks them due
+static RateClock *rateClocks= NULL;
+
+// RMS execution defaults of the dll list lines without options, read once per process ( 'rmsIterations' < 0 until then )
+static int32_T rmsIterations= -1;
+static real64_T rmsTolerance= 0;
+
+// Steady-state initialization, read once per process ( 'settleSteps' < 0 until then )
+static int32_T settleSteps= -1;
+static real64_T settleTolerance= 1e-9;
+
+// I/O recording, read once per process ( 'recordMode' < 0 until then, 0 off, 1 on )
+static int32_T recordMode= -1;
+static const char *recordPrefix= NULL;
+static const char *recordInstances= NULL;
+
+// General message tracking, read once per process ( 'messageCap' < 0 until then )
+static int32_T messageCap= -1;
+
+// Checkpoints, read once per process ( 'checkpointMode' < 0 until then, 0 off, 1 on )
+static int32_T checkpointMode= -1;
+static const char *checkpointPrefix= NULL;
+static real64_T checkpointTime= 0;
 
 
 
-void outsix_( char *, int32_T * );
 void stoptp_( char *, int * );
 
-// Print in  '.LIS' file
+// Print in  '.LIS' file, queued until the next flush of the log
 void printLIS_( const char *fmt, ... ) {
 
-  char buffer[512];                                                                                       
   va_list args;
 
   va_start( args, fmt );
-  vsprintf( buffer, fmt, args );                                                                          
+  dllLogV( DLL_LOG_INFO, fmt, args );
   va_end( args );
 
-  int32_T len= strlen( buffer );                                                                              
-  outsix_( buffer, &len );                                                                               
-
 }
 
 // Stop the simulation in a 'well-ordered manner'
 void stopSim( const char *fmt, ... ) {
   
-  char buffer[512];
+  char buffer[ DLL_LOG_LINE ];
   va_list args;
 
   va_start( args, fmt );
-  vsprintf( buffer, fmt, args );
+  vsnprintf( buffer, sizeof( buffer ), fmt, args );
   va_end( args );
 
   printLIS_( "_________________________________________________________________________________________________________________________________" );
   printLIS_( "_________________________________________________________________________________________________________________________________\n\n" );
 
-  printLIS_( "ERROR: \n%s\n", buffer );
+  dllLog( DLL_LOG_ERROR, "ERROR: \n%s\n", buffer );
 
   printLIS_( "_________________________________________________________________________________________________________________________________" );
   printLIS_( "_________________________________________________________________________________________________________________________________\n\n" );
 
+  dllLogFlush();
+
   char msg[]= "Stopping ATP simulation due to error";
   int len= strlen( msg );
   stoptp_( msg, &len );
 
 }
 
-// Read the external dll model
-char readDlls( char *dllName, size_t bufferSize  ) {
+// Read every dll of the list once, the list location comes from 'DLL_ONE_LIST' ( default: 'dll_list.txt' in the working directory )
+static void readDllList( void ) {
 
-  pFile= fopen( "C:/ATP/libmingw_2024/dll_list.txt", "r" );
-  // char dllName[128]= { 0 };
+  const char *listPath= getenv( DLL_LIST_ENV );
+  if ( listPath == NULL || listPath[0] == '\0' ) {
+    listPath= DLL_LIST_DEFAULT;
+  }
 
-  if ( pFile != NULL && fgets( dllName, bufferSize, pFile ) != NULL ) {
-    dllName[ strcspn( dllName, "\r\n" ) ]= '\0';
-  } else {
-    stopSim( "Could not read dll from file\n" );
+  FILE *pFile= fopen( listPath, "r" );
+  if ( pFile == NULL ) {
+    stopSim( "Could not read dll list \"%s\" ( see %s )\n", listPath, DLL_LIST_ENV );
+  }
+
+  char line[ MAX_PATH ];
+  int32_T capDlls= 0;
+
+  while ( fgets( line, sizeof( line ), pFile ) != NULL ) {
+
+    line[ strcspn( line, "\r\n" ) ]= '\0';
+    if ( line[0] == '\0' ) continue;
+
+    if ( numDlls == capDlls ) {
+      capDlls= ( capDlls > 0 ) ? 2 * capDlls : 8;
+      DllListEntry *grown= realloc( dllList, capDlls * sizeof( DllListEntry ) );
+      if ( grown == NULL ) {
+        stopSim( "Memory allocation failed for the dll list\n" );
+      }
+      dllList= grown;
+    }
+
+    DllListEntry *entry= &dllList[ numDlls++ ];
+    entry -> rmsIterations= -1;
+    entry -> rmsTolerance= -1;
+
+    // 'path | rms=<n> tol=<x>': the options follow the path, which may contain spaces
+    char *options= strchr( line, DLL_LIST_OPTIONS );
+    if ( options != NULL ) {
+
+      char *end= options;
+      while ( end > line && ( end[-1] == ' ' || end[-1] == '\t' ) ) end--;
+      *end= '\0';
+
+      char *word= strtok( options + 1, " \t" );
+      for ( ; word != NULL; word= strtok( NULL, " \t" ) ) {
+        if ( strncmp( word, "rms=", 4 ) == 0 ) {
+          entry -> rmsIterations= atoi( word + 4 );
+          if ( entry -> rmsIterations < 0 ) entry -> rmsIterations= 0;
+        } else if ( strncmp( word, "tol=", 4 ) == 0 ) {
+          entry -> rmsTolerance= atof( word + 4 );
+        } else {
+          stopSim( "Unknown option '%s' in line %d of dll list \"%s\"\n", word, numDlls, listPath );
+        }
+      }
+    }
+
+    entry -> path= malloc( strlen( line ) + 1 );
+    if ( entry -> path == NULL ) {
+      stopSim( "Memory allocation failed for the dll list\n" );
+    }
+
+    strcpy( entry -> path, line );
   }
 
   fclose( pFile );
-  printLIS_( "Archivo txt= %s\n", dllName );
 
+  if ( numDlls == 0 ) {
+    stopSim( "Dll list \"%s\" is empty\n", listPath );
+  }
+
+  printLIS_( "Dll list= %s ( %d dlls )\n", listPath, numDlls );
+
+}
+
+// Lay out the ports of one kind from the static model information, once per module
+static void buildModuleLayout( const char *label, DllPortLayout *layout, IEEE_Cigre_DLLInterface_Model_Info *modelInfo ) {
+
+  // Offsets and conversion plan, reused by every instance at every step
+  int32_T status= buildModelLayout( label, modelInfo, layout );
+
+  if ( status == DLL_LAYOUT_NO_MEMORY ) {
+    stopSim( "Memory allocation failed in buildModuleLayout for the '%s' layout\n", label );
+  } else if ( status != DLL_LAYOUT_OK ) {
+    stopSim( "%s[%d] : %s has an unsupported data type ( %d )\n", label, status, modelPortName( label, modelInfo, status ), modelPortType( label, modelInfo, status ) );
+  }
+
+  printLIS_( "%s: %d ports ( %d values ) in %d conversion runs\n", label, layout -> size, layout -> numValues, layout -> numRuns );
+
+}
+
+// Log sink handed to the models through 'Model_SetLogSink', 'context' is their module
+static void modelLogSink( void *context, int32_T level, const char_T *message ) {
+
+  DllModule *module= ( DllModule * ) context;
+  dllLog( level, "%s: %s", module -> modelInfo -> ModelName, message );
+
+}
+
+// Return the registered module for a dll, loading it and resolving its entry points the first time it is used
+DllModule* acquireModule( const char *dllName ) {
+
+  // The name goes to the loader as written, so bare names keep the LoadLibrary search order. Names of the same dll
+  // ( relative, absolute, other case on Windows ) load the same module handle, which is the registry key
+  HMODULE hDLL= LoadLibrary( dllName );
   if ( hDLL == NULL ) {
-    hDLL= LoadLibrary( dllName );
-    if ( hDLL == NULL ) {
-      stopSim( "Cannot find dll file \"%s\"\n", dllName  );
+    stopSim( "Cannot find dll file \"%s\"\n", dllName );
+  }
+
+  DllModule *module;
+  for ( module= modules; module != NULL; module= module -> next ) {
+    if ( module -> hDLL == hDLL ) {
+      FreeLibrary( hDLL );                                                    // The registry holds one loader reference per dll
+      module -> refCount++;
+      return module;
     }
   }
 
+  module= calloc( 1, sizeof( DllModule ) );
+  if ( module == NULL ) {
+    stopSim( "Memory allocation failed for 'DllModule'\n" );
+  }
+
+  snprintf( module -> path, sizeof( module -> path ), "%s", dllName );
+  module -> hDLL= hDLL;
+  const char *path= module -> path;
+
+  const char *missing= resolveModelEntries( module -> hDLL, &module -> entries );
+  if ( missing != NULL ) {
+    stopSim( "Cannot locate '%s' function in dll %s\n", missing, path );
+  }
+
+  module -> modelInfo= module -> entries.getInfo();
+  module -> refCount= 1;
+
+  // Models that support the logging extension report through the '.LIS' log instead of the console
+  if ( module -> entries.modelSetLogSink != NULL ) {
+    module -> entries.modelSetLogSink( modelLogSink, module, dllLogThreshold() );
+  }
+
+  // Every instance of the dll shares these layouts
+  buildModuleLayout( "Inputs", &module -> inputs, module -> modelInfo );
+  buildModuleLayout( "Parameters", &module -> params, module -> modelInfo );
+  buildModuleLayout( "Outputs", &module -> outputs, module -> modelInfo );
+
+  buildStateLayout( &module -> states, module -> modelInfo -> NumIntStates, module -> modelInfo -> NumFloatStates, module -> modelInfo -> NumDoubleStates );
+
+  module -> paramsScratch= malloc( module -> params.totalSize > 0 ? module -> params.totalSize : 1 );
+  if ( module -> paramsScratch == NULL ) {
+    stopSim( "Memory allocation failed for the parameters of dll %s\n", path );
+  }
+
+  module -> next= modules;
+  modules= module;
+
+  printLIS_( "Loaded dll= %s\n", path );
+
+  return module;
+
 }
 
-// Compute the amount of memory to reserve depending on the data type and number of 'Inputs', 'Outputs', and 'Parameters' the DLL model needs
-void getAlignmentSizeAndOffset( int32_T type, int32_T *alignment, size_t *currentOffset, size_t *offsets, int32_T i ) {
+// Drop one reference to a module, unloading the dll with the last one
+void releaseModule( DllModule *module ) {
 
-  switch ( type ) {
-    case IEEE_Cigre_DLLInterface_DataType_char_T: *alignment= sizeof( char_T ); break;
-    case IEEE_Cigre_DLLInterface_DataType_int8_T: *alignment= sizeof( int8_T ); break;
-    case IEEE_Cigre_DLLInterface_DataType_uint8_T: *alignment= sizeof( uint8_T ); break;
-    case IEEE_Cigre_DLLInterface_DataType_int16_T: *alignment= sizeof( int16_T ); break;
-    case IEEE_Cigre_DLLInterface_DataType_uint16_T: *alignment= sizeof( uint16_T ); break;
-    case IEEE_Cigre_DLLInterface_DataType_int32_T: *alignment= sizeof( int32_T ); break;
-    case IEEE_Cigre_DLLInterface_DataType_uint32_T: *alignment= sizeof( uint32_T ); break;
-    case IEEE_Cigre_DLLInterface_DataType_real32_T: *alignment= sizeof( real32_T ); break;
-    case IEEE_Cigre_DLLInterface_DataType_real64_T: *alignment= sizeof( real64_T ); break;
-    // case IEEE_Cigre_DLLInterface_DataType_c_string_T: *alignment= sizeof( '\0' ); break;
+  if ( --module -> refCount > 0 ) return;
+
+  DllModule **link;
+  for ( link= &modules; *link != NULL; link= &( *link ) -> next ) {
+    if ( *link == module ) {
+      *link= module -> next;
+      break;
+    }
   }
 
-  size_t remainder= *currentOffset % *alignment;
-  if ( remainder != 0 ) *currentOffset += ( *alignment - remainder );                                                                     // If ( remainder != 0 ),  currentOffset remains the same
+  freePortLayout( &module -> inputs );
+  freePortLayout( &module -> params );
+  freePortLayout( &module -> outputs );
+  free( module -> paramsScratch );                                                                            // The interned blocks go with the arena
+  FreeLibrary( module -> hDLL );
+  free( module );
+
+}
+
+// Return the module of the dll selected by 'dllIndex' in the dll list
+DllModule* readDlls( int32_T dllIndex ) {
 
-  offsets[i]= *currentOffset;
+  if ( dllList == NULL ) {
+    readDllList();
+  }
 
-  *currentOffset += *alignment;
+  if ( dllIndex < 1 || dllIndex > numDlls ) {
+    stopSim( "Dll index %d is out of the dll list range [ 1, %d ]\n", dllIndex, numDlls );
+  }
+
+  return acquireModule( dllList[ dllIndex - 1 ].path );
 
 }
 
-// Assign the data type to a vector based on a structure coming from the dll model
-void changeDataType( double *valuesFromATP, int *types, size_t *offsets, int size, double *valuesToModel ) { 
+// FNV-1a of 'size' bytes, continuing from 'hash'
+static uint64_t hashBytes( uint64_t hash, const void *data, size_t size ) {
 
-  int32_T i;
+  const uint8_T *bytes= ( const uint8_T * ) data;
+  size_t i;
 
-  // Write the values into 'valuesToModel':
   for ( i= 0; i < size; i++ ) {
+    hash= ( hash ^ bytes[i] ) * FNV_PRIME;
+  }
 
-    switch ( types[i] ) {
+  return hash;
 
-      case IEEE_Cigre_DLLInterface_DataType_char_T: {
-        char_T val= ( char_T )( valuesFromATP[i] );                                                                                             
-        *( ( char_T* )( ( uint8_T* ) valuesToModel + offsets[i] ) )= val;
-        break;
-      }
+}
 
-      case IEEE_Cigre_DLLInterface_DataType_int8_T: {
-        int8_T val= ( int8_T )( valuesFromATP[i] );                                                                                             
-        *( ( int8_T* )( ( uint8_T* ) valuesToModel + offsets[i] ) )= val;
-        break;
-      }
-      
-      case IEEE_Cigre_DLLInterface_DataType_uint8_T: {
-        uint8_T val= ( uint8_T )( valuesFromATP[i] );                                                                                             
-        *( ( uint8_T* )( ( uint8_T* ) valuesToModel + offsets[i] ) )= val;
-        break;
-      }
+// Zeroed block of the instance arena, stop the simulation when out of memory
+static void* instanceAlloc( size_t size, const char *what ) {
 
-      case IEEE_Cigre_DLLInterface_DataType_int16_T: {
-        int16_T val= ( int16_T )( valuesFromATP[i] );                                                                                             
-        *( ( int16_T* )( ( uint8_T* ) valuesToModel + offsets[i] ) )= val;
-        break;
-      }
+  void *ptr= arenaAlloc( &instanceArena, size );
 
-      case IEEE_Cigre_DLLInterface_DataType_uint16_T: {
-        uint16_T val= ( uint16_T )( valuesFromATP[i] );                                                                                             
-        *( ( uint16_T* )( ( uint8_T* ) valuesToModel + offsets[i] ) )= val;
-        break;
-      }
+  if ( ptr == NULL ) {
+    stopSim( "Memory allocation failed for '%s'\n", what );
+  }
 
-      case IEEE_Cigre_DLLInterface_DataType_int32_T: {
-        int32_T val= ( int32_T )( valuesFromATP[i] );                                                                                             
-        *( ( int32_T* )( ( uint8_T* ) valuesToModel + offsets[i] ) )= val;
-        break;
-      }
+  return ptr;
 
-      case IEEE_Cigre_DLLInterface_DataType_uint32_T: {
-        uint32_T val= ( uint32_T )( valuesFromATP[i] );                                                                                             
-        *( ( uint32_T* )( ( uint8_T* ) valuesToModel + offsets[i] ) )= val;
-        break;
-      }
+}
 
-      case IEEE_Cigre_DLLInterface_DataType_real32_T: {
-        real32_T val= ( real32_T )( valuesFromATP[i] );                                                                                             
-        *( ( real32_T* )( ( uint8_T* ) valuesToModel + offsets[i] ) )= val;
-        break;
-      }
+// Shared copy of a checked parameter block: the block of an instance with the same bytes, or a new one in the arena.
+// The model checks ( and may rewrite, as SCRX9 clamps TE and TB ) its own private block, so the shared ones never change
+static void* internParameters( DllModule *module, const void *values ) {
+
+  size_t size= module -> params.totalSize;
+  uint64_t hash= hashBytes( FNV_OFFSET_BASIS, values, size );
+
+  DllParamBlock *block;
+  for ( block= module -> paramBlocks; block != NULL; block= block -> next ) {
+    if ( block -> hash == hash && memcmp( block -> values, values, size ) == 0 ) {
+      block -> refCount++;
+      printLIS_( "Parameters: shared with %d instances\n", block -> refCount - 1 );
+      return block -> values;
+    }
+  }
+
+  block= instanceAlloc( sizeof( DllParamBlock ), "DllParamBlock" );
+  block -> values= instanceAlloc( size, "Parameters" );
+  memcpy( block -> values, values, size );
+  block -> hash= hash;
+  block -> refCount= 1;
+  block -> next= module -> paramBlocks;
+  module -> paramBlocks= block;
+
+  return block -> values;
+
+}
+
+// Fill the buffer of the ports of one kind with the ATP values, a new instance buffer when 'valuesToModel' is NULL
+void* processModelVector( const char *label, int32_T size, const DllPortLayout *layout, IEEE_Cigre_DLLInterface_Model_Info *modelInfo, real64_T *valuesFromATP, void *valuesToModel ) {
+
+  if ( valuesToModel == NULL ) {
+    valuesToModel= instanceAlloc( layout -> totalSize, "valuesToModel" );
+  }
+
+  // Write the values into 'valuesToModel':
+  changeDataType( valuesFromATP, layout, valuesToModel );
+
+
+  // Print the values
+  if ( !dllLogEnabled( DLL_LOG_DEBUG ) ) return valuesToModel;
 
-      case IEEE_Cigre_DLLInterface_DataType_real64_T: {
-        real64_T val= ( real64_T )( valuesFromATP[i] );
-        *( ( real64_T* )( ( uint8_T* ) valuesToModel + offsets[i] ) )= val;                                                                         // memcpy( ( uint8_t* )buffer + offset, &val, sizeof( real64_T ) );
-        break;
+  int32_T i, k;
+  for ( i= 0; i < size; i++ ) {
+    for ( k= 0; k < layout -> widths[i]; k++ ) {
+      if ( layout -> types[i] == IEEE_Cigre_DLLInterface_DataType_int32_T ) {
+        int32_T value= ( ( int32_T * )( ( uint8_t * )( valuesToModel ) + layout -> offsets[i] ) )[k];
+        dllLog( DLL_LOG_DEBUG, "%s_M[%d] : %s[%d] = %d ( int32_T )\n", label, i, modelPortName( label, modelInfo, i ), k, value );
+      } else if ( layout -> types[i] == IEEE_Cigre_DLLInterface_DataType_real64_T ) {
+        real64_T value= ( ( real64_T * )( ( uint8_t * )( valuesToModel ) + layout -> offsets[i] ) )[k];
+        dllLog( DLL_LOG_DEBUG, "%s_M[%d] : %s[%d] = %.4f ( real64_T )\n", label, i, modelPortName( label, modelInfo, i ), k, value );
       }
+    }
+  }
+
+  return valuesToModel;
+
+}
 
+// Count a general message of an instance, 1 the first time it is seen ( to be printed )
+static int32_T countMessage( DllInstance *ctx, const char *message ) {
+
+  uint64_t hash= hashBytes( FNV_OFFSET_BASIS, message, strlen( message ) );
+  real64_T t= ctx -> ptr_toModel -> Time;
+  int32_T i;
+
+  // Cold data, out of the instance slab: most instances never report a message
+  if ( ctx -> messages == NULL ) {
+
+    if ( messageCap < 0 ) {
+      const char *cap= getenv( MESSAGE_CAP_ENV );
+      messageCap= ( cap != NULL ) ? atoi( cap ) : MESSAGE_CAP_DEFAULT;
+      if ( messageCap < 0 ) messageCap= 0;
     }
 
-  }  
+    ctx -> messages= malloc( ( messageCap > 0 ? messageCap : 1 ) * sizeof( DllMessageCount ) );
+    if ( ctx -> messages == NULL ) {
+      stopSim( "Memory allocation failed for the messages of instance %d\n", ctx -> handle );
+    }
+  }
+
+  for ( i= 0; i < ctx -> numMessages; i++ ) {
+    DllMessageCount *seen= &ctx -> messages[i];
+    if ( seen -> hash == hash ) {
+      seen -> count++;
+      seen -> lastTime= t;
+      return 0;
+    }
+  }
+
+  if ( ctx -> numMessages == messageCap ) {
+    if ( ctx -> otherMessages++ == 0 ) {
+      dllLog( DLL_LOG_WARNING, "Warning: instance %d reached %d distinct messages, the next ones are only counted\n", ctx -> handle, messageCap );
+    }
+    return 0;
+  }
+
+  DllMessageCount *seen= &ctx -> messages[ ctx -> numMessages++ ];
+  seen -> hash= hash;
+  seen -> count= 1;
+  seen -> firstTime= t;
+  seen -> lastTime= t;
+  snprintf( seen -> text, sizeof( seen -> text ), "%s", message );
+  seen -> text[ strcspn( seen -> text, "\r\n" ) ]= '\0';
+
+  return 1;
 
 }
 
-// Create 'Input', 'Output' and 'Parameters' vectors with the data type that the DLL model needs
-void* processModelVector( const char *label, int32_T size, int32_T *types, size_t *offsets, IEEE_Cigre_DLLInterface_Model_Info *modelInfo, real64_T *valuesFromATP ) {
+// Shows "LastGeneralMessage" or "LastErrorMessage" if a warning or an error appears, a general message only the first
+// time the instance reports it
+void showErrorIfAny( DllInstance *ctx, int32_T fcn ) {
 
-  const char **names= malloc( size * sizeof( char * ) );
+  IEEE_Cigre_DLLInterface_Instance *ptr_toModel= ctx -> ptr_toModel;
 
-  if ( !names ) {
-    stopSim( "Memory allocation failed in processModelVector for 'names'\n" );
+  if ( fcn == 1 ) {
+    const char *message= ( ptr_toModel -> LastGeneralMessage != NULL ) ? ptr_toModel -> LastGeneralMessage : "";
+    if ( countMessage( ctx, message ) ) {
+      dllLog( DLL_LOG_WARNING, "GeneralMessage= %s\n", message );
+    }
+  } else if ( fcn == 2 ) {
+    dllLog( DLL_LOG_ERROR, "ErrorMessage= %s\n", ptr_toModel -> LastErrorMessage );
+    stopSim( "" );                                                                        // Shows anything
   }
 
+}
+
+// Repeated and uncounted general messages of an instance, at the end of the simulation
+static void reportMessages( DllInstance *ctx ) {
+
   int32_T i;
-  for ( i= 0; i < size; i++ ) {
 
-    if ( strcmp( label, "Inputs" ) == 0 ) {            
-      names[i]= ( const char * ) modelInfo -> InputPortsInfo[i].Name;                                                           
-      types[i]= ( int32_T ) modelInfo -> InputPortsInfo[i].DataType;
-    } else if ( strcmp( label, "Outputs" ) == 0 ) {
-      names[i]= ( const char * ) modelInfo -> OutputPortsInfo[i].Name;                                                           
-      types[i]= ( int32_T ) modelInfo -> OutputPortsInfo[i].DataType;
-    } else if ( strcmp( label, "Parameters" ) == 0 ) {
-      names[i]= ( const char * ) modelInfo -> ParametersInfo[i].Name;                                                            
-      types[i]= ( int32_T ) modelInfo -> ParametersInfo[i].DataType;                
+  for ( i= 0; i < ctx -> numMessages; i++ ) {
+    DllMessageCount *seen= &ctx -> messages[i];
+    if ( seen -> count > 1 ) {
+      dllLog( DLL_LOG_WARNING, "Messages: instance %d, \"%s\" x%d ( t= %g .. %g )\n", ctx -> handle, seen -> text, seen -> count, seen -> firstTime, seen -> lastTime );
     }
+  }
 
+  if ( ctx -> otherMessages > 0 ) {
+    dllLog( DLL_LOG_WARNING, "Messages: instance %d, %d more messages past the cap of %d\n", ctx -> handle, ctx -> otherMessages, messageCap );
   }
 
-  size_t totalSize= 0;
-  int32_T alignment= 0;
+}
+
+// Terminate the models and release every instance when the simulation ends. ATP has no such call: hosts that know
+// the end of the simulation ( dll_one_driver ) call it, ATP runs only with DLL_ONE_TERMINATE, at process exit
+void dll_one_t__( void ) {
+
+  int32_T i;
+  for ( i= 0; i < numInstances; i++ ) {
+
+    DllInstance *ctx= instances[i];
+
+    if ( ctx -> module != NULL && ctx -> module -> entries.modelTerminate != NULL ) {
+      ctx -> module -> entries.modelTerminate( ctx -> ptr_toModel );
+    }
+
+    reportMessages( ctx );
+    free( ctx -> messages );
+
+    if ( ctx -> recorder != NULL ) {
+      printLIS_( "Record: instance %d, %lld model calls\n", ctx -> handle, recorderCount( ctx -> recorder ) );
+      recorderClose( ctx -> recorder );
+    }
+
+    if ( ctx -> module != NULL ) {
+      releaseModule( ctx -> module );
+    }
 
-  for ( i= 0; i < size; i++ ) {
-    getAlignmentSizeAndOffset( types[i], &alignment, &totalSize, offsets, i );
   }
 
-  void *valuesToModel= malloc( totalSize );
+  arenaRelease( &instanceArena );                                                                             // Contexts, layouts and buffers of every instance
+  free( instances );
+  instances= NULL;
+  numInstances= 0;
+  capInstances= 0;
+  lastFound= 0;
 
-  if ( !valuesToModel ) {
-    stopSim( "Memory allocation failed in processModelVector for 'valuesToModel'\n" );
+  for ( i= 0; i < numDlls; i++ ) {
+    free( dllList[i].path );
   }
 
-  // Write the values into 'valuesToModel':
-  changeDataType( valuesFromATP, types, offsets, size, valuesToModel );
+  free( dllList );
+  dllList= NULL;
+  numDlls= 0;
 
+  while ( rateClocks != NULL ) {
 
-  // Print the values
-  for ( i= 0; i < size; i++ ) {
-    if ( types[i] == IEEE_Cigre_DLLInterface_DataType_int32_T ) {
-      int32_T value= *( int32_T * )( ( uint8_t * )( valuesToModel ) + offsets[i] );
-      printLIS_( "%s_M[%d] : %s = %d ( int32_T )\n", label, i, names[i], value );
-    } else if ( types[i] == IEEE_Cigre_DLLInterface_DataType_real64_T ) {
-      real64_T value= *( real64_T * )( ( uint8_t * )( valuesToModel ) + offsets[i] );
-      printLIS_( "%s_M[%d] : %s = %.4f ( real64_T )\n", label, i, names[i], value );
+    RateClock *clock= rateClocks;
+    rateClocks= clock -> next;
+
+    while ( clock -> groups != NULL ) {
+      RateGroup *group= clock -> groups;
+      clock -> groups= group -> next;
+      free( group );
     }
+
+    free( clock );
   }
 
-  free( names );
-  return valuesToModel;
+  dllLogFlush();                                                                                              // Messages of the last steps and of Model_Terminate
 
 }
 
-// Return back the values to ATP in 'double' data type
-void writeValuesToATP( void *valuesFromModel, int *types, size_t *offsets, int size, double *valuesToATP ) { 
+// Process exit without DLL_ONE_TERMINATE: no model code and no '.LIS' output, only the record files are completed
+static void closeRecorders( void ) {
 
   int32_T i;
-  for ( i= 0; i < size; i++ ) {
+  for ( i= 0; i < numInstances; i++ ) {
+    if ( instances[i] -> recorder != NULL ) {
+      recorderClose( instances[i] -> recorder );
+      instances[i] -> recorder= NULL;
+    }
+  }
 
-    double valueAsDouble;
+}
 
-    switch ( types[i] ) {
+// Add a new context to the instance table, found again by its 'xdata' array
+DllInstance* allocInstance( double xdata_ar[] ) {
 
-      case IEEE_Cigre_DLLInterface_DataType_char_T: {
-        char_T val= *( char_T * )( ( uint8_T * ) valuesFromModel + offsets[i] );                                                                                            // Initial validation with the aim of 'jump' the first value from ATP because that value is the simulation time
-        valueAsDouble= ( double ) val;
-        break;
-      }
+  if ( numInstances == capInstances ) {
 
-      case IEEE_Cigre_DLLInterface_DataType_int8_T: {
-        int8_T val= *( int8_T * )( ( uint8_t * ) valuesFromModel + offsets[i] );                                                                                            // Initial validation with the aim of 'jump' the first value from ATP because that value is the simulation time
-        valueAsDouble= ( double ) val;
-        break;
-      }
-      
-      case IEEE_Cigre_DLLInterface_DataType_uint8_T: {
-        uint8_T val= *( uint8_T * )( ( uint8_t * ) valuesFromModel + offsets[i] );                                                                                            // Initial validation with the aim of 'jump' the first value from ATP because that value is the simulation time
-        valueAsDouble= ( double ) val;
-        break;
-      }
+    if ( !exitHandler ) {
+      const char *terminate= getenv( TERMINATE_ENV );
+      atexit( ( terminate != NULL && atoi( terminate ) > 0 ) ? dll_one_t__ : closeRecorders );
+      exitHandler= 1;
+    }
 
-      case IEEE_Cigre_DLLInterface_DataType_int16_T: {
-        int16_T val= *( int16_T * )( ( uint8_t * ) valuesFromModel + offsets[i] );                                                                                            // Initial validation with the aim of 'jump' the first value from ATP because that value is the simulation time
-        valueAsDouble= ( double ) val;
-        break;
-      }
+    int32_T newCap= ( capInstances > 0 ) ? 2 * capInstances : 16;
+    DllInstance **grown= realloc( instances, newCap * sizeof( DllInstance * ) );
 
-      case IEEE_Cigre_DLLInterface_DataType_uint16_T: {
-        uint16_T val= *( uint16_T * )( ( uint8_t * ) valuesFromModel + offsets[i] );                                                                                            // Initial validation with the aim of 'jump' the first value from ATP because that value is the simulation time
-        valueAsDouble= ( double ) val;
-        break;
-      }
+    if ( grown == NULL ) {
+      stopSim( "Memory allocation failed for the instance table\n" );
+    }
 
-      case IEEE_Cigre_DLLInterface_DataType_int32_T: {
-        int32_T val= *( int32_T * )( ( uint8_t * ) valuesFromModel + offsets[i] );                                                                                         // Initial validation with the aim of 'jump' the first value from ATP because that value is the simulation time
-        valueAsDouble= ( double ) val;
-        break;
-      }
-      
-      case IEEE_Cigre_DLLInterface_DataType_uint32_T: {
-        uint32_T val= *( uint32_T * )( ( uint8_t * ) valuesFromModel + offsets[i] );                                                                                            // Initial validation with the aim of 'jump' the first value from ATP because that value is the simulation time
-        valueAsDouble= ( double ) val;
-        break;
-      }
+    instances= grown;
+    capInstances= newCap;
+  }
 
-      case IEEE_Cigre_DLLInterface_DataType_real32_T: {
-        real32_T val= *( real32_T * )( ( uint8_t * ) valuesFromModel + offsets[i] );                                                                                            // Initial validation with the aim of 'jump' the first value from ATP because that value is the simulation time
-        valueAsDouble= ( double ) val;
-        break;
-      }
+  DllInstance *ctx= instanceAlloc( sizeof( DllInstance ), "DllInstance" );
+  ctx -> ptr_toModel= instanceAlloc( sizeof( IEEE_Cigre_DLLInterface_Instance ), "ptr_toModel" );         // Next to its context
 
-      case IEEE_Cigre_DLLInterface_DataType_real64_T: {
-        real64_T val= *( real64_T * )( ( uint8_t * ) valuesFromModel + offsets[i] );    
-        valueAsDouble= ( double ) val;
-        break;
-      }
+  int32_T i;
+  for ( i= 0; i < numInstances; i++ ) {
+    if ( instances[i] -> xdata == xdata_ar ) instances[i] -> xdata= NULL;                                 // A new data case reuses the MODELS storage
+  }
 
+  instances[ numInstances++ ]= ctx;
+  ctx -> lastTick= -1;
+  ctx -> handle= numInstances;
+  ctx -> xdata= xdata_ar;
+
+  return ctx;
+
+}
+
+// Recover the context of the calling instance from its 'xdata' array. ATP calls the instances in the same order at
+// every step, so the search starting after the last one found ends at its first probe
+static inline DllInstance* findInstance( double xdata_ar[] ) {
+
+  int32_T i;
+  for ( i= 0; i < numInstances; i++ ) {
+
+    if ( ++lastFound >= numInstances ) lastFound= 0;
+
+    if ( instances[ lastFound ] -> xdata == xdata_ar ) {
+      return instances[ lastFound ];
     }
+  }
 
-    valuesToATP[i]= valueAsDouble;
-    
+  stopSim( "No instance uses this 'xdata', was 'dll_one_i' called?\n" );
+  return NULL;
+
+}
+
+// Hand the ATP inputs to the model: point at 'xin_ar' for zero-copy layouts, convert into the own buffer otherwise
+static inline void bindInputs( DllInstance *ctx, double xin_ar[] ) {
+
+  if ( ctx -> inputs -> zeroCopy ) {
+    ctx -> ptr_toModel -> ExternalInputs= xin_ar;
+  } else {
+    changeDataType( xin_ar, ctx -> inputs, ctx -> inputsBuffer );
   }
 
 }
 
-// Shows "LastGeneralMessage" or "LastErrorMessage" if a warning or an error appears
-void showErrorIfAny( int32_T fcn ) {
+// Let the model write straight into 'xout_ar' for zero-copy layouts
+static inline void bindOutputs( DllInstance *ctx, double xout_ar[] ) {
 
-  if ( fcn == 1 ) {
-    printLIS_( "GeneralMessage= %s\n", ptr_toModel -> LastGeneralMessage );
-  } else if ( fcn == 2 ) {
-    printLIS_( "ErrorMessage= %s\n", ptr_toModel -> LastErrorMessage );
-    stopSim( "" );                                                                        // Shows anything
+  if ( !ctx -> outputs -> zeroCopy ) return;
+
+  if ( ctx -> ptr_toModel -> ExternalOutputs == ctx -> outputsBuffer ) {
+    memcpy( xout_ar, ctx -> outputsBuffer, ctx -> outputs -> totalSize );                   // First step out of the own buffer, carry the last outputs over
+  }
+
+  ctx -> ptr_toModel -> ExternalOutputs= xout_ar;
+
+}
+
+// Return the model's outputs values to ATP, already there for zero-copy layouts
+static inline void returnOutputs( DllInstance *ctx, double xout_ar[] ) {
+
+  if ( !ctx -> outputs -> zeroCopy ) {
+    writeValuesToATP( ctx -> outputsBuffer, ctx -> outputs, xout_ar );
+  }
+
+}
+
+// 1 if 'DLL_ONE_RECORD_INSTANCES' selects the instance ( every instance when not set )
+static int32_T recordSelected( int32_T handle ) {
+
+  if ( recordInstances == NULL || recordInstances[0] == '\0' ) return 1;
+
+  const char *p= recordInstances;
+  while ( *p != '\0' ) {
+    char *end;
+    long selected= strtol( p, &end, 10 );
+    if ( end == p ) break;
+    if ( selected == handle ) return 1;
+    p= ( *end == ',' ) ? end + 1 : end;
+  }
+
+  return 0;
+
+}
+
+// Start the I/O record of an instance once its parameters are final, when 'DLL_ONE_RECORD' asks for it
+static void openRecorder( DllInstance *ctx ) {
+
+  if ( recordMode < 0 ) {
+    recordPrefix= getenv( RECORD_ENV );
+    recordInstances= getenv( RECORD_INSTANCES_ENV );
+    recordMode= ( recordPrefix != NULL && recordPrefix[0] != '\0' ) ? 1 : 0;
+  }
+
+  if ( recordMode == 0 || !recordSelected( ctx -> handle ) ) return;
+
+  IEEE_Cigre_DLLInterface_Model_Info *modelInfo= ctx -> module -> modelInfo;
+  const DllStateLayout *states= &ctx -> module -> states;
+  DllRecordHeader header;
+
+  memset( &header, 0, sizeof( header ) );
+  memcpy( header.magic, DLL_RECORD_MAGIC, sizeof( DLL_RECORD_MAGIC ) );
+  header.version= DLL_RECORD_VERSION;
+  header.headerSize= sizeof( DllRecordHeader );
+  snprintf( header.modelName, sizeof( header.modelName ), "%s", modelInfo -> ModelName );
+  snprintf( header.modelVersion, sizeof( header.modelVersion ), "%s", modelInfo -> ModelVersion );
+  header.handle= ctx -> handle;
+  header.numInputPorts= modelInfo -> NumInputPorts;
+  header.numOutputPorts= modelInfo -> NumOutputPorts;
+  header.numParameters= modelInfo -> NumParameters;
+  header.inputsSize= ( int32_T ) ctx -> inputs -> totalSize;
+  header.outputsSize= ( int32_T ) ctx -> outputs -> totalSize;
+  header.paramsSize= ( int32_T ) ctx -> params -> totalSize;
+  header.numIntStates= modelInfo -> NumIntStates;
+  header.numFloatStates= modelInfo -> NumFloatStates;
+  header.numDoubleStates= modelInfo -> NumDoubleStates;
+  header.statesSize= ( int32_T ) states -> totalSize;
+  header.recordSize= ( int32_T )( sizeof( real64_T ) + dllRecordAlign( ctx -> inputs -> totalSize ) + dllRecordAlign( ctx -> outputs -> totalSize ) +
+                                  dllRecordAlign( states -> totalSize ) );
+  header.sampleTime= modelInfo -> FixedStepBaseSampleTime;
+  header.timeStep= ctx -> timeStep;
+
+  char path[ MAX_PATH ];
+  snprintf( path, sizeof( path ), "%s_%d.rec", recordPrefix, ctx -> handle );
+
+  ctx -> recorder= recorderOpen( path, &header, ctx -> ptr_toModel -> Parameters );
+
+  if ( ctx -> recorder == NULL ) {
+    dllLog( DLL_LOG_WARNING, "Warning: Record: cannot create %s\n", path );
+  } else {
+    printLIS_( "Record: %s ( %d bytes per model call )\n", path, header.recordSize );
+  }
+
+}
+
+// Append the time, marshalled inputs and outputs and the states of the last model call to the I/O record. The outputs
+// are the ones ATP receives: the model's, or 'heldOutputs' ( ATP values ) while they are held
+static void recordStep( DllInstance *ctx, const double *heldOutputs ) {
+
+  uint8_T *slot= recorderNext( ctx -> recorder );
+
+  if ( slot == NULL ) {
+    dllLog( DLL_LOG_WARNING, "Warning: Record: instance %d, the file cannot grow, recording stopped at t= %g\n", ctx -> handle, ctx -> ptr_toModel -> Time );
+    recorderClose( ctx -> recorder );
+    ctx -> recorder= NULL;
+    return;
+  }
+
+  IEEE_Cigre_DLLInterface_Instance *ptr_toModel= ctx -> ptr_toModel;
+  size_t inputsSize= ctx -> inputs -> totalSize;
+  size_t outputsSize= ctx -> outputs -> totalSize;
+
+  memcpy( slot, &ptr_toModel -> Time, sizeof( real64_T ) );                      slot += sizeof( real64_T );
+  memcpy( slot, ptr_toModel -> ExternalInputs, inputsSize );                     slot += dllRecordAlign( inputsSize );
+  if ( heldOutputs != NULL ) {
+    changeDataType( heldOutputs, ctx -> outputs, slot );
+  } else {
+    memcpy( slot, ptr_toModel -> ExternalOutputs, outputsSize );
+  }
+  slot += dllRecordAlign( outputsSize );
+
+  memcpy( slot, ctx -> statesBase, ctx -> module -> states.totalSize );
+
+}
+
+// EMT = 1, RMS = 2: RMS when the dll list line ( 'rms=' ) or 'DLL_ONE_RMS_ITERATIONS' asks for Model_Iterate calls
+static uint8_T readRMSMode( DllInstance *ctx, const DllListEntry *entry ) {
+
+  if ( rmsIterations < 0 ) {
+
+    const char *iterations= getenv( RMS_ITERATIONS_ENV );
+    const char *tolerance= getenv( RMS_TOLERANCE_ENV );
+
+    rmsIterations= ( iterations != NULL ) ? atoi( iterations ) : 0;
+    if ( rmsIterations < 0 ) rmsIterations= 0;
+    rmsTolerance= ( tolerance != NULL ) ? atof( tolerance ) : 0;
   }
 
+  ctx -> rmsIterations= ( entry -> rmsIterations >= 0 ) ? entry -> rmsIterations : rmsIterations;
+  ctx -> rmsTolerance= ( entry -> rmsTolerance >= 0 ) ? entry -> rmsTolerance : rmsTolerance;
+
+  if ( ctx -> rmsIterations > 0 ) {
+    printLIS_( "RMS mode: up to %d Model_Iterate calls per step, tolerance= %g\n", ctx -> rmsIterations, ctx -> rmsTolerance );
+  }
+
+  return ( ctx -> rmsIterations > 0 ) ? 2 : 1;
+
+}
+
+// RMS mode: call Model_Iterate after Model_Outputs until the outputs stop changing or the instance's 'rmsIterations' is reached
+static void iterateRMS( DllInstance *ctx, double xout_ar[] ) {
+
+  IEEE_Cigre_DLLInterface_Instance *ptr_toModel= ctx -> ptr_toModel;
+  ModelCall modelIterate= ctx -> module -> entries.modelIterate;
+
+  int32_T numValues= ctx -> outputs -> numValues;
+  double *prev= ctx -> rmsOutputs;
+  int32_T n, i;
+
+  if ( modelIterate == NULL ) return;
+
+  for ( n= 0; n < ctx -> rmsIterations; n++ ) {
+
+    memcpy( prev, xout_ar, numValues * sizeof( double ) );
+
+    int32_T mIterate= modelIterate( ptr_toModel );
+    showErrorIfAny( ctx, mIterate );
+
+    returnOutputs( ctx, xout_ar );
+
+    for ( i= 0; i < numValues; i++ ) {
+      real64_T scale= fabs( prev[i] ) > 1 ? fabs( prev[i] ) : 1;
+      if ( fabs( xout_ar[i] - prev[i] ) > ctx -> rmsTolerance * scale ) break;
+    }
+
+    if ( i == numValues ) return;                                                                              // Converged
+
+  }
+
+}
+
+// Run the model 'subSteps' times over the last ATP step, with the inputs linearly interpolated between both ATP samples
+static void subcycleOutputs( DllInstance *ctx, double xin_ar[], double xout_ar[], real64_T t ) {
+
+  IEEE_Cigre_DLLInterface_Instance *ptr_toModel= ctx -> ptr_toModel;
+  ModelCall modelOutputs= ctx -> module -> entries.modelOutputs;
+
+  int32_T numValues= ctx -> inputs -> numValues;
+  double *prev= ctx -> prevInputs;
+  double *sub= ctx -> subInputs;
+  real64_T t0= t - ctx -> timeStep;
+  real64_T subStep= ctx -> timeStep / ctx -> subSteps;                       // Same spacing as the interpolation, 'timeStepDLL' may not divide 'timeStep'
+
+  int32_T k, i;
+
+  bindOutputs( ctx, xout_ar );
+
+  for ( k= 1; k <= ctx -> subSteps; k++ ) {
+
+    if ( k < ctx -> subSteps ) {
+      real64_T alpha= ( real64_T ) k / ctx -> subSteps;
+      for ( i= 0; i < numValues; i++ ) sub[i]= prev[i] + alpha * ( xin_ar[i] - prev[i] );
+      bindInputs( ctx, sub );
+      ptr_toModel -> Time= t0 + k * subStep + ctx -> timeOffset;
+    } else {
+      bindInputs( ctx, xin_ar );                                                                             // Last call lands on the ATP sample itself
+      ptr_toModel -> Time= t + ctx -> timeOffset;
+    }
+
+    int32_T modelOut= modelOutputs( ptr_toModel );
+    showErrorIfAny( ctx, modelOut );
+
+    if ( ctx -> rmsIterations > 0 ) {
+      returnOutputs( ctx, xout_ar );                                                                         // iterateRMS compares the ATP values
+      iterateRMS( ctx, xout_ar );
+    }
+
+    if ( ctx -> recorder != NULL ) recordStep( ctx, NULL );
+
+  }
+
+  memcpy( prev, xin_ar, numValues * sizeof( double ) );
+
+  returnOutputs( ctx, xout_ar );
+
+}
+
+// Put a rate group in the wheel slot of its next due step
+static inline void scheduleRateGroup( RateGroup *group ) {
+
+  RateGroup **slot= &group -> clock -> wheel[ group -> nextTick % RATE_WHEEL_SLOTS ];
+  group -> nextInSlot= *slot;
+  *slot= group;
+
+}
+
+// Step counter of the instances with this ATP time step. A clock that already stepped starts over with the new data
+// case whose 'dll_one_i' asks for it
+static RateClock* acquireRateClock( real64_T timeStep ) {
+
+  RateClock *clock;
+  for ( clock= rateClocks; clock != NULL; clock= clock -> next ) {
+    if ( clock -> timeStep == timeStep ) break;
+  }
+
+  if ( clock == NULL ) {
+
+    clock= calloc( 1, sizeof( RateClock ) );
+    if ( clock == NULL ) {
+      stopSim( "Memory allocation failed for 'RateClock'\n" );
+    }
+
+    clock -> timeStep= timeStep;
+    clock -> tick= -1;
+    clock -> next= rateClocks;
+    rateClocks= clock;
+  }
+
+  if ( clock -> tick >= 0 ) clock -> restart= 1;                                                               // ATP already stepped: the time starts over
+
+  return clock;
+
+}
+
+// Rate group of the instances of 'clock' called every 'period' ATP steps, first due 'phase' ATP steps after the next one
+static RateGroup* acquireRateGroup( RateClock *clock, int32_T period, int32_T phase ) {
+
+  RateGroup *group;
+  for ( group= clock -> groups; group != NULL; group= group -> next ) {
+    if ( group -> period == period && group -> phase == phase ) return group;
+  }
+
+  group= calloc( 1, sizeof( RateGroup ) );
+  if ( group == NULL ) {
+    stopSim( "Memory allocation failed for 'RateGroup'\n" );
+  }
+
+  group -> clock= clock;
+  group -> period= period;
+  group -> phase= phase;
+  group -> nextTick= clock -> tick + 1 + phase;
+  group -> dueTick= -1;
+  group -> next= clock -> groups;
+  clock -> groups= group;
+  scheduleRateGroup( group );
+
+  return group;
+
+}
+
+// New data case: every group of the clock is due on the current ATP step again, as on the first step of the first case
+static void rephaseRateGroups( RateClock *clock ) {
+
+  RateGroup *group;
+
+  memset( clock -> wheel, 0, sizeof( clock -> wheel ) );
+
+  for ( group= clock -> groups; group != NULL; group= group -> next ) {
+    group -> nextTick= clock -> tick + group -> phase;
+    group -> dueTick= -1;
+    scheduleRateGroup( group );
+  }
+
+  clock -> restart= 0;
+
+}
+
+// The first instance of a clock called at a new simulation time advances its ATP step and marks the groups of its wheel
+// slot that are due. The step counter never goes back, so the 'lastTick' of the instances stays valid across data cases
+static inline void advanceTick( RateClock *clock, real64_T t ) {
+
+  if ( clock -> tick >= 0 && t == clock -> tickTime && !clock -> restart ) return;
+
+  int32_T restart= clock -> restart || ( clock -> tick >= 0 && t < clock -> tickTime );
+
+  clock -> tick++;
+  clock -> tickTime= t;
+
+  if ( restart ) rephaseRateGroups( clock );
+
+  RateGroup **link= &clock -> wheel[ clock -> tick % RATE_WHEEL_SLOTS ];
+
+  while ( *link != NULL ) {
+
+    RateGroup *group= *link;
+
+    if ( group -> nextTick != clock -> tick ) {                                                              // Due on a later turn of the wheel
+      link= &group -> nextInSlot;
+      continue;
+    }
+
+    *link= group -> nextInSlot;
+    group -> dueTick= clock -> tick;
+    group -> nextTick += group -> period;
+    scheduleRateGroup( group );
+
+  }
+
+}
+
+// Before 'TRelease': re-initialize the model only when its marshalled inputs differ bitwise from the last ones, and
+// return the initial outputs to ATP
+static void holdOutputs( DllInstance *ctx, double xin_ar[], double xout_ar[] ) {
+
+  IEEE_Cigre_DLLInterface_Instance *ptr_toModel= ctx -> ptr_toModel;
+  size_t size= ctx -> inputs -> totalSize;
+
+  bindInputs( ctx, xin_ar );
+
+  if ( !ctx -> heldValid || memcmp( ptr_toModel -> ExternalInputs, ctx -> heldInputs, size ) != 0 ) {
+
+    memcpy( ctx -> heldInputs, ptr_toModel -> ExternalInputs, size );
+    ctx -> heldValid= 1;
+
+    int32_T modelInit= ctx -> module -> entries.modelInitialize( ptr_toModel );
+    showErrorIfAny( ctx, modelInit );
+
+    int32_T modelOut= ctx -> module -> entries.modelOutputs( ptr_toModel );
+    showErrorIfAny( ctx, modelOut );
+
+  }
+
+  memcpy( xout_ar, ctx -> initialOutputs, ctx -> outputs -> numValues * sizeof( double ) );
+
+}
+
+// Run Model_Outputs with the inputs held at their initial values, outside ATP, until the double states stop changing or
+// 'DLL_ONE_SETTLE_STEPS' calls are spent. 'Time' is held at the initialization time too: the settling happens before
+// ATP starts, and the first ATP step must not see the model clock ahead of it. The settled outputs go to 'xout_ar'
+static void settleModel( DllInstance *ctx, double xout_ar[] ) {
+
+  if ( settleSteps < 0 ) {
+
+    const char *steps= getenv( SETTLE_STEPS_ENV );
+    const char *tolerance= getenv( SETTLE_TOLERANCE_ENV );
+
+    settleSteps= ( steps != NULL ) ? atoi( steps ) : 0;
+    if ( settleSteps < 0 ) settleSteps= 0;
+    if ( tolerance != NULL ) settleTolerance= atof( tolerance );
+  }
+
+  if ( settleSteps == 0 ) return;
+
+  IEEE_Cigre_DLLInterface_Instance *ptr_toModel= ctx -> ptr_toModel;
+  int32_T numStates= ctx -> module -> modelInfo -> NumDoubleStates;
+  real64_T *states= ptr_toModel -> DoubleStates;
+
+  if ( numStates == 0 ) {
+    printLIS_( "Settle: the model has no double states, skipped\n" );
+    return;
+  }
+
+  real64_T *prev= malloc( numStates * sizeof( real64_T ) );
+  if ( prev == NULL ) {
+    stopSim( "Memory allocation failed for the settle states\n" );
+  }
+
+  int32_T n, i;
+  real64_T change= 0;
+
+  for ( n= 1; n <= settleSteps; n++ ) {
+
+    memcpy( prev, states, numStates * sizeof( real64_T ) );
+
+    int32_T modelOut= ctx -> module -> entries.modelOutputs( ptr_toModel );
+    showErrorIfAny( ctx, modelOut );
+
+    change= 0;
+    for ( i= 0; i < numStates; i++ ) {
+      real64_T scale= fabs( prev[i] ) > 1 ? fabs( prev[i] ) : 1;
+      real64_T relative= fabs( states[i] - prev[i] ) / scale;
+      if ( relative > change ) change= relative;
+    }
+
+    if ( change <= settleTolerance ) break;
+
+  }
+
+  free( prev );
+
+  if ( n <= settleSteps ) {
+    printLIS_( "Settle: steady state after %d Model_Outputs calls\n", n );
+  } else {
+    dllLog( DLL_LOG_WARNING, "Warning: Settle: no steady state after %d Model_Outputs calls ( last state change= %g )\n", settleSteps, change );
+  }
+
+  if ( ptr_toModel -> ExternalOutputs != xout_ar ) {                                                         // Zero-copy: already there
+    writeValuesToATP( ptr_toModel -> ExternalOutputs, ctx -> outputs, xout_ar );
+  }
+
+  // The settled state must survive the hold, it was reached with these inputs
+  if ( ctx -> heldInputs != NULL ) {
+    memcpy( ctx -> heldInputs, ptr_toModel -> ExternalInputs, ctx -> inputs -> totalSize );
+    ctx -> heldValid= 1;
+  }
+
+}
+
+// FNV-1a hash of the model name and the marshalled parameter block, a checkpoint only fits the same model and parameters
+static uint64_t paramsHash( DllInstance *ctx ) {
+
+  const char *name= ctx -> module -> modelInfo -> ModelName;
+  uint64_t hash= hashBytes( FNV_OFFSET_BASIS, name, strlen( name ) );
+
+  return hashBytes( hash, ctx -> ptr_toModel -> Parameters, ctx -> params -> totalSize );
+
+}
+
+// Open the checkpoint file of an instance, NULL when checkpoints are off or the file cannot be opened
+static FILE* openCheckpoint( DllInstance *ctx, const char *mode ) {
+
+  if ( checkpointMode < 0 ) {
+
+    const char *time= getenv( CHECKPOINT_TIME_ENV );
+
+    checkpointPrefix= getenv( CHECKPOINT_ENV );
+    checkpointMode= ( checkpointPrefix != NULL && checkpointPrefix[0] != '\0' ) ? 1 : 0;
+    checkpointTime= ( time != NULL ) ? atof( time ) : 0;
+  }
+
+  if ( checkpointMode == 0 ) return NULL;
+
+  char path[ MAX_PATH ];
+  snprintf( path, sizeof( path ), "%s_%d_%d.chk", checkpointPrefix, ctx -> dllIndex, ctx -> dllOrder );             // Stable while other dlls gain or lose instances
+
+  return fopen( path, mode );
+
+}
+
+// Restore the states, outputs and schedule of an instance; 0 when there is no usable checkpoint ( normal initialization )
+static int32_T restoreCheckpoint( DllInstance *ctx, double xout_ar[] ) {
+
+  FILE *pFile= openCheckpoint( ctx, "rb" );
+  if ( checkpointMode == 1 ) ctx -> checkpointPending= 1;
+  if ( pFile == NULL ) return 0;
+
+  IEEE_Cigre_DLLInterface_Model_Info *modelInfo= ctx -> module -> modelInfo;
+  IEEE_Cigre_DLLInterface_Instance *ptr_toModel= ctx -> ptr_toModel;
+  DllCheckpointHeader header;
+
+  size_t intBytes= modelInfo -> NumIntStates * sizeof( int32_T );
+  size_t floatBytes= modelInfo -> NumFloatStates * sizeof( real32_T );
+  size_t doubleBytes= modelInfo -> NumDoubleStates * sizeof( real64_T );
+  int32_T numPrevInputs= ( ctx -> prevInputs != NULL ) ? ctx -> inputs -> numValues : 0;
+  size_t prevBytes= numPrevInputs * sizeof( double );
+  size_t payloadBytes= intBytes + floatBytes + doubleBytes + ctx -> outputs -> totalSize + prevBytes;
+  real64_T t= ptr_toModel -> Time;
+
+  uint8_T *payload= NULL;
+  int32_T restored= 0;
+
+  if ( fread( &header, sizeof( header ), 1, pFile ) != 1 || memcmp( header.magic, CHECKPOINT_MAGIC, sizeof( header.magic ) ) != 0 ) {
+    printLIS_( "Checkpoint: instance %d, invalid file, normal initialization\n", ctx -> handle );
+  } else if ( header.paramsHash != paramsHash( ctx ) ) {
+    printLIS_( "Checkpoint: instance %d, parameters changed, normal initialization\n", ctx -> handle );
+  } else if ( header.numIntStates != modelInfo -> NumIntStates || header.numFloatStates != modelInfo -> NumFloatStates ||
+              header.numDoubleStates != modelInfo -> NumDoubleStates || header.outputsSize != ( int32_T ) ctx -> outputs -> totalSize ||
+              header.ticksPerCall != ctx -> ticksPerCall || header.subSteps != ctx -> subSteps || header.numPrevInputs != numPrevInputs ||
+              header.nextCall < 1 || header.nextCall > ctx -> ticksPerCall ) {
+    printLIS_( "Checkpoint: instance %d, model or time step changed, normal initialization\n", ctx -> handle );
+  } else if ( ( payload= malloc( payloadBytes > 0 ? payloadBytes : 1 ) ) == NULL || fread( payload, 1, payloadBytes, pFile ) != payloadBytes ) {
+    printLIS_( "Checkpoint: instance %d, truncated file, normal initialization\n", ctx -> handle );
+  } else {
+
+    uint8_T *p= payload;
+    if ( intBytes > 0 ) memcpy( ptr_toModel -> IntStates, p, intBytes );                                   // No state array when its count is 0
+    p += intBytes;
+    if ( floatBytes > 0 ) memcpy( ptr_toModel -> FloatStates, p, floatBytes );
+    p += floatBytes;
+    if ( doubleBytes > 0 ) memcpy( ptr_toModel -> DoubleStates, p, doubleBytes );
+    p += doubleBytes;
+    memcpy( ctx -> outputsBuffer, p, ctx -> outputs -> totalSize );
+    p += ctx -> outputs -> totalSize;
+    if ( prevBytes > 0 ) memcpy( ctx -> prevInputs, p, prevBytes );
+
+    writeValuesToATP( ctx -> outputsBuffer, ctx -> outputs, xout_ar );
+
+    // Same call phase as the saved run: the next call comes 'nextCall' ATP steps after the checkpoint
+    ctx -> rateGroup= acquireRateGroup( ctx -> rateGroup -> clock, ctx -> ticksPerCall, header.nextCall - 1 );
+
+    // The model carries on from the saved time while ATP starts over: its 'Time' keeps the saved offset
+    ctx -> timeOffset= header.time - t;
+    ptr_toModel -> Time= header.time;
+
+    ctx -> TRelease= 0;                                                                                      // Already settled, no hold
+    ctx -> checkpointPending= 0;
+    restored= 1;
+    printLIS_( "Checkpoint: instance %d restored ( saved at t= %g, model time = ATP time %+g )\n", ctx -> handle, header.time, ctx -> timeOffset );
+  }
+
+  free( payload );
+  fclose( pFile );
+
+  return restored;
+
+}
+
+// Save the states, outputs and schedule of an instance once the simulation reaches 'DLL_ONE_CHECKPOINT_TIME'
+static void saveCheckpoint( DllInstance *ctx, real64_T t ) {
+
+  if ( !ctx -> checkpointPending || t < checkpointTime ) return;
+  ctx -> checkpointPending= 0;
+
+  FILE *pFile= openCheckpoint( ctx, "wb" );
+  if ( pFile == NULL ) {
+    dllLog( DLL_LOG_WARNING, "Warning: Checkpoint: cannot write the file of instance %d\n", ctx -> handle );
+    return;
+  }
+
+  IEEE_Cigre_DLLInterface_Model_Info *modelInfo= ctx -> module -> modelInfo;
+  IEEE_Cigre_DLLInterface_Instance *ptr_toModel= ctx -> ptr_toModel;
+  DllCheckpointHeader header;
+
+  memset( &header, 0, sizeof( header ) );
+  memcpy( header.magic, CHECKPOINT_MAGIC, sizeof( header.magic ) );
+  header.paramsHash= paramsHash( ctx );
+  header.numIntStates= modelInfo -> NumIntStates;
+  header.numFloatStates= modelInfo -> NumFloatStates;
+  header.numDoubleStates= modelInfo -> NumDoubleStates;
+  header.outputsSize= ( int32_T ) ctx -> outputs -> totalSize;
+  header.ticksPerCall= ctx -> ticksPerCall;
+  header.subSteps= ctx -> subSteps;
+  RateClock *clock= ctx -> rateGroup -> clock;
+  header.nextCall= clock -> restart ? 1 : ( int32_T )( ctx -> rateGroup -> nextTick - clock -> tick );       // 1 before the first step of a data case
+  header.numPrevInputs= ( ctx -> prevInputs != NULL ) ? ctx -> inputs -> numValues : 0;
+  header.time= t + ctx -> timeOffset;                                                                         // Model time
+
+  fwrite( &header, sizeof( header ), 1, pFile );
+  if ( modelInfo -> NumIntStates > 0 ) fwrite( ptr_toModel -> IntStates, sizeof( int32_T ), modelInfo -> NumIntStates, pFile );
+  if ( modelInfo -> NumFloatStates > 0 ) fwrite( ptr_toModel -> FloatStates, sizeof( real32_T ), modelInfo -> NumFloatStates, pFile );
+  if ( modelInfo -> NumDoubleStates > 0 ) fwrite( ptr_toModel -> DoubleStates, sizeof( real64_T ), modelInfo -> NumDoubleStates, pFile );
+  fwrite( ptr_toModel -> ExternalOutputs, 1, ctx -> outputs -> totalSize, pFile );                             // Own buffer or 'xout_ar', same bytes
+  if ( header.numPrevInputs > 0 ) fwrite( ctx -> prevInputs, sizeof( double ), header.numPrevInputs, pFile );
+
+  if ( fclose( pFile ) != 0 ) {
+    dllLog( DLL_LOG_WARNING, "Warning: Checkpoint: cannot write the file of instance %d\n", ctx -> handle );
+  } else {
+    printLIS_( "Checkpoint: instance %d saved at t= %g\n", ctx -> handle, t );
+  }
+
+}
+
+// Count the model calls in whole ATP steps, so the call timing does not drift with the simulation time
+void scheduleCalls( DllInstance *ctx ) {
+
+  real64_T ratio= ( ctx -> timeStep > 0 && ctx -> timeStepDLL > 0 ) ? ctx -> timeStepDLL / ctx -> timeStep : 1.0;
+  real64_T ticks= floor( ratio + 0.5 );
+
+  ctx -> subSteps= 1;
+
+  if ( ticks < 1 ) {
+
+    // A model faster than ATP is called every ATP step, several times ( subcycling )
+    ticks= 1;
+    ratio= ctx -> timeStep / ctx -> timeStepDLL;
+    real64_T subSteps= floor( ratio + 0.5 );
+
+    if ( fabs( ratio - subSteps ) > 1e-6 * ratio ) {
+      dllLog( DLL_LOG_WARNING, "Warning: TimeStep= %g is not a multiple of TimeStepDLL= %g, the model is called %.0f times per ATP step ( %g s )\n",
+                             ctx -> timeStep, ctx -> timeStepDLL, subSteps, ctx -> timeStep / subSteps );
+    }
+
+    ctx -> subSteps= ( int32_T ) subSteps;
+
+  } else if ( fabs( ratio - ticks ) > 1e-6 * ratio ) {
+    dllLog( DLL_LOG_WARNING, "Warning: TimeStepDLL= %g is not a multiple of TimeStep= %g, the model is called every %.0f ATP steps ( %g s )\n",
+                           ctx -> timeStepDLL, ctx -> timeStep, ticks, ticks * ctx -> timeStep );
+  }
+
+  ctx -> ticksPerCall= ( int32_T ) ticks;
+  ctx -> rateGroup= acquireRateGroup( acquireRateClock( ctx -> timeStep ), ctx -> ticksPerCall, 0 );
+  printLIS_( "Model called every %d ATP steps, %d times per call\n", ctx -> ticksPerCall, ctx -> subSteps );
+
 }
 
 
@@ -349,52 +1398,74 @@ void dll_one_i__( double xdata_ar[], double xin_ar[], double xout_ar[], double x
 
   printLIS_( "Initializing model 'dll_one_i'" );
   
+
+  DllInstance *ctx= allocInstance( xdata_ar );
+  printLIS_( "Instance handle= %d\n", numInstances );
+
   
-  // Read the external DLL models
+  // Read the external DLL models, the first 'xdata' value selects the dll in the list. Cases written before the dll
+  // index start with a parameter or the time step there: stop rather than shift every value by one
 
-  char dllName[128];
-  readDlls( dllName, sizeof( dllName )  ); 
-  // readDlls( "scm_32" );                                         // realCodeExample     scm_32       scm_Photon
+  int32_T dllIndex= ( int32_T )( xdata_ar[ XDATA_DLL_INDEX ] + 0.5 );
 
+  if ( fabs( xdata_ar[ XDATA_DLL_INDEX ] - dllIndex ) > 1e-9 ) {
+    stopSim( "xdata[1]= %g is not a dll index, the case predates the dll list: prepend the index ( 'xdata[1..n+3]:= [ 1, ... ]' )\n", xdata_ar[ XDATA_DLL_INDEX ] );
+  }
 
+  DllModule *module= ctx -> module= readDlls( dllIndex ); 
+  ctx -> dllIndex= dllIndex;
+  ctx -> dllOrder= module -> refCount;
+  printLIS_( "Dll[%d]= %s ( %d instances )\n", dllIndex, module -> path, module -> refCount );
 
-  // ___________________________________________________________________
+  ctx -> inputs= &module -> inputs;                                           // Read-only, shared by every instance of the dll
+  ctx -> params= &module -> params;
+  ctx -> outputs= &module -> outputs;
 
 
 
-  // GetInfo function
+  // ___________________________________________________________________
 
-  GetInfo getInfo= ( GetInfo ) GetProcAddress( hDLL, "Model_GetInfo" );
-  if ( getInfo == NULL ) {
-    stopSim( "Cannot locate 'Model_GetInfo' function in dll %s\n", dllName );
-  } 
 
-  IEEE_Cigre_DLLInterface_Model_Info *modelInfo= getInfo();
+
+  // Model information, resolved once per dll
+
+  IEEE_Cigre_DLLInterface_Model_Info *modelInfo= module -> modelInfo;
   printLIS_( "Model Inputs: \n Name= %s\n", modelInfo -> ModelName );
   
-  sizeInputs=  modelInfo -> NumInputPorts;
-  sizeOutputs= modelInfo -> NumOutputPorts;
-  sizeParams=  modelInfo -> NumParameters;
+  int32_T sizeInputs=  modelInfo -> NumInputPorts;
+  int32_T sizeOutputs= modelInfo -> NumOutputPorts;
+  int32_T sizeParams=  modelInfo -> NumParameters;
+
+  // Array ports take 'Width' consecutive ATP values
+  int32_T valuesInputs= signalValues( modelInfo -> InputPortsInfo, sizeInputs );
+  int32_T valuesOutputs= signalValues( modelInfo -> OutputPortsInfo, sizeOutputs );
+  ctx -> timeIndex= valuesInputs + valuesOutputs;
 
   int32_T sizeNumIntStates= modelInfo -> NumIntStates;
   int32_T sizeNumFloatStates= modelInfo -> NumFloatStates;
   int32_T sizeNumDoubleStates= modelInfo -> NumDoubleStates;
 
-  int32_T i;
-  real64_T t= ( real64_T ) xin_ar[ sizeInputs + sizeOutputs ];
-  timeStep= ( real64_T ) xdata_ar[ sizeParams ];
-  timeStepDLL= modelInfo -> FixedStepBaseSampleTime;  
-  nextTimeStepDLL= 0;
-  TRelease= ( real64_T ) xdata_ar[ sizeParams + 1 ];
-  printLIS_( "Time= %f - TimeStep= %f - TimeStepDLL= %f- TRelease= %f\n", t, timeStep, timeStepDLL, TRelease );
+  real64_T t= ( real64_T ) xin_ar[ ctx -> timeIndex ];
+  ctx -> timeStep= ( real64_T ) xdata_ar[ XDATA_PARAMS + sizeParams ];
+  ctx -> timeStepDLL= modelInfo -> FixedStepBaseSampleTime;  
+  ctx -> TRelease= ( real64_T ) xdata_ar[ XDATA_PARAMS + sizeParams + 1 ];
+
+  if ( !( ctx -> timeStep > 0 ) ) {
+    stopSim( "Time step %g in xdata[%d] is not positive, 'ixdata' must be %d: [ dllIndex, parameters, timestep, TRelease ]\n", ctx -> timeStep, XDATA_PARAMS + sizeParams + 1, sizeParams + 3 );
+  }
+  ctx -> startTime= t;
+  printLIS_( "Time= %f - TimeStep= %f - TimeStepDLL= %f- TRelease= %f\n", t, ctx -> timeStep, ctx -> timeStepDLL, ctx -> TRelease );
+
+  scheduleCalls( ctx );
 
 
-  printLIS_( "N Inputs= %d\n", sizeInputs );
-  printLIS_( "N Outputs= %d\n", sizeOutputs );
+  printLIS_( "N Inputs= %d ( %d values )\n", sizeInputs, valuesInputs );
+  printLIS_( "N Outputs= %d ( %d values )\n", sizeOutputs, valuesOutputs );
   printLIS_( "N Parameters= %d\n", sizeParams );
   printLIS_( "N IntStates= %d\n", sizeNumIntStates );
   printLIS_( "N FloatStates= %d\n", sizeNumFloatStates );
-  printLIS_( "N DoubleStates= %d\n", sizeNumDoubleStates ); 
+  printLIS_( "N DoubleStates= %d\n", sizeNumDoubleStates );
+  printLIS_( "States= %d bytes in %d 'xvar' slots\n", ( int32_T ) module -> states.totalSize, module -> states.numSlots );
   
 
 
@@ -405,9 +1476,15 @@ void dll_one_i__( double xdata_ar[], double xin_ar[], double xout_ar[], double x
   // IEEE_Cigre_DLLInterface_Signal - Inputs
   printLIS_( "Model Inputs: \n" );  
   
-  inputsTypes= malloc( sizeInputs * sizeof( int32_T ) );  
-  inputsOffsets= malloc( sizeInputs * sizeof( size_t ) );
-  void *InputSignals= processModelVector( "Inputs", sizeInputs, inputsTypes, inputsOffsets, modelInfo, xin_ar );
+  void *InputSignals= processModelVector( "Inputs", sizeInputs, ctx -> inputs, modelInfo, xin_ar, NULL );
+
+  // Subcycling interpolates the inputs from the previous ATP step, the first one starts from the initial inputs
+  if ( ctx -> subSteps > 1 ) {
+
+    ctx -> prevInputs= instanceAlloc( valuesInputs * sizeof( double ), "prevInputs" );
+    ctx -> subInputs= instanceAlloc( valuesInputs * sizeof( double ), "subInputs" );
+    memcpy( ctx -> prevInputs, xin_ar, valuesInputs * sizeof( double ) );
+  }
 
 
 
@@ -418,9 +1495,9 @@ void dll_one_i__( double xdata_ar[], double xin_ar[], double xout_ar[], double x
   // IEEE_Cigre_DLLInterface_Parameter
   printLIS_( "Model Parameters: \n" );
 
-  int32_T *paramsTypes= malloc( sizeParams * sizeof( int ) );  
-  size_t *paramsOffsets= malloc( sizeParams * sizeof( size_t ) );
-  void *Parameters= processModelVector( "Parameters", sizeParams, paramsTypes, paramsOffsets, modelInfo, xdata_ar );
+  // Marshalled into the module scratch block first, interned once Model_CheckParameters has seen it
+  memset( module -> paramsScratch, 0, ctx -> params -> totalSize );                                        // Padding takes part in the comparison
+  void *Parameters= processModelVector( "Parameters", sizeParams, ctx -> params, modelInfo, xdata_ar + XDATA_PARAMS, module -> paramsScratch );
 
   
   
@@ -432,15 +1509,19 @@ void dll_one_i__( double xdata_ar[], double xin_ar[], double xout_ar[], double x
   printLIS_( "Model Outputs: \n" );  
     
 
-  outputsTypes= malloc( sizeOutputs * sizeof( int ) );  
-  outputsOffsets= malloc( sizeOutputs * sizeof( size_t ) );
-
     // Initializing outputs array from ATP
-  for ( i= sizeInputs; i < ( sizeInputs + sizeOutputs ); ++i ) {
-    xout_ar[ i - sizeInputs ]= xin_ar[i];
-  }
+  memcpy( xout_ar, xin_ar + valuesInputs, valuesOutputs * sizeof( double ) );
 
-  void *OutputSignals= processModelVector( "Outputs", sizeOutputs, outputsTypes, outputsOffsets, modelInfo, xout_ar );
+  void *OutputSignals= processModelVector( "Outputs", sizeOutputs, ctx -> outputs, modelInfo, xout_ar, NULL );
+
+  // Hold mode keeps the initial outputs and the inputs of the last re-initialization
+  if ( ctx -> TRelease > 0 ) {
+
+    ctx -> heldInputs= instanceAlloc( ctx -> inputs -> totalSize, "heldInputs" );
+    ctx -> initialOutputs= instanceAlloc( valuesOutputs * sizeof( double ), "initialOutputs" );
+    memcpy( ctx -> initialOutputs, xout_ar, valuesOutputs * sizeof( double ) );
+    ctx -> heldValid= 0;                                                      // The first held step initializes as before
+  }
 
 
   
@@ -449,137 +1530,165 @@ void dll_one_i__( double xdata_ar[], double xin_ar[], double xout_ar[], double x
 
 
     
-  ptr_toModel= ( IEEE_Cigre_DLLInterface_Instance * ) malloc( sizeof( IEEE_Cigre_DLLInterface_Instance ) );
+  IEEE_Cigre_DLLInterface_Instance *ptr_toModel= ctx -> ptr_toModel;
 
-  if ( ptr_toModel == NULL ) {
-    stopSim( "Memory allocation failed for 'ptr_toModel'\n" );
-  }
+  ctx -> inputsBuffer= InputSignals;
+  ctx -> outputsBuffer= OutputSignals;
 
-  ptr_toModel -> ExternalInputs= InputSignals;                    // InputSignals
-  ptr_toModel -> ExternalOutputs= OutputSignals;                  // OutputSignals
-  ptr_toModel -> Parameters= Parameters;                          // Parameters
-  ptr_toModel -> Time= t;
-  // ptr_toModel -> SimTool_EMT_RMS_Mode= 1;
-  ptr_toModel -> LastErrorMessage= "LastErrorMessage";       
-  ptr_toModel -> LastGeneralMessage= "LastGeneralMessage";     
+  uint8_T mode= readRMSMode( ctx, &dllList[ dllIndex - 1 ] );
 
-  ptr_toModel -> IntStates= ( sizeNumIntStates > 0 ) ? ( int32_T *) xvar_ar : NULL;   
-  ptr_toModel -> FloatStates= ( sizeNumFloatStates > 0 ) ? ( real32_T *) xvar_ar + sizeNumIntStates : NULL;  
-  ptr_toModel -> DoubleStates= ( sizeNumDoubleStates > 0 ) ? ( real64_T *) xvar_ar + sizeNumIntStates + sizeNumFloatStates : NULL;
+  if ( ctx -> rmsIterations > 0 ) {
+    ctx -> rmsOutputs= instanceAlloc( valuesOutputs * sizeof( double ), "rmsOutputs" );
+  }
+
+  // The model states fill 'xvar', packed by byte offset ( 'ixvar' = numSlots )
+  uint8_T *xstates_ar= ( uint8_T * ) xvar_ar;
+  const DllStateLayout *states= &module -> states;
+  ctx -> statesBase= xstates_ar;
+
+  // 'SimTool_EMT_RMS_Mode' is const for the model: the instance is built whole and copied into its arena block
+  IEEE_Cigre_DLLInterface_Instance modelInstance= {
+    .ExternalInputs= InputSignals,
+    .ExternalOutputs= OutputSignals,
+    .Parameters= Parameters,
+    .Time= t,
+    .SimTool_EMT_RMS_Mode= mode,                                              // Read-only for the model, set once by the simulation tool
+    .LastErrorMessage= "LastErrorMessage",
+    .LastGeneralMessage= "LastGeneralMessage",
+    .IntStates= ( sizeNumIntStates > 0 ) ? ( int32_T * )( xstates_ar + states -> intOffset ) : NULL,
+    .FloatStates= ( sizeNumFloatStates > 0 ) ? ( real32_T * )( xstates_ar + states -> floatOffset ) : NULL,
+    .DoubleStates= ( sizeNumDoubleStates > 0 ) ? ( real64_T * )( xstates_ar + states -> doubleOffset ) : NULL
+  };
+
+  memcpy( ptr_toModel, &modelInstance, sizeof( IEEE_Cigre_DLLInterface_Instance ) );
   
   
 
 
   
+  printLIS_( "Zero-copy: Inputs= %d - Outputs= %d\n", ctx -> inputs -> zeroCopy, ctx -> outputs -> zeroCopy );
+
   printLIS_( "_________________________________________________________________________________________________________________________________\n\n" );
 
   
   
   int32_T firstCall;
-  ModelFirstCall modelFirstCall= ( ModelFirstCall ) GetProcAddress( hDLL, "Model_FirstCall" );
-  if ( modelFirstCall != NULL ) {
-    firstCall= modelFirstCall( ptr_toModel );
+  if ( module -> entries.modelFirstCall != NULL ) {
+    firstCall= module -> entries.modelFirstCall( ptr_toModel );
     printLIS_( "FirstCall: %i\n", firstCall );
-    showErrorIfAny( firstCall );
+    showErrorIfAny( ctx, firstCall );
   } 
 
 
 
-  int32_T checkParams;
-  CheckParameters checkParameters= ( CheckParameters ) GetProcAddress( hDLL, "Model_CheckParameters" );
-  if ( checkParameters == NULL ) {
-    stopSim( "Cannot locate 'Model_CheckParameters' function in dll %s\n", dllName );
-  } else {
-    checkParams= checkParameters( ptr_toModel );
-    printLIS_( "CheckParams: %i\n", checkParams );
-    showErrorIfAny( checkParams );
-  } 
+  int32_T checkParams= module -> entries.checkParameters( ptr_toModel );
+  printLIS_( "CheckParams: %i\n", checkParams );
+  showErrorIfAny( ctx, checkParams );
 
+  // The checked parameters are final: share the block of an identical instance
+  ptr_toModel -> Parameters= internParameters( module, ptr_toModel -> Parameters );
 
+  openRecorder( ctx );
 
-  modelInitialize= ( ModelInitialize ) GetProcAddress( hDLL, "Model_Initialize" );
-  if ( modelInitialize == NULL ) {
-    stopSim( "Cannot locate 'Model_Initialize' function in dll %s\n", dllName );
-  }  
 
 
-
-  modelOutputs= ( ModelOutputs ) GetProcAddress( hDLL, "Model_Outputs" );
-  if ( modelOutputs == NULL ) {
-    stopSim( "Cannot locate 'Model_Outputs' function in dll %s\n", dllName );    
+  // A checkpoint of the same model and parameters replaces the initialization and the settling
+  if ( restoreCheckpoint( ctx, xout_ar ) ) {
+    dllLogFlush();
+    return;
   }
 
 
 
   int32_T mIterate;
-  ModelIterate modelIterate= ( ModelIterate ) GetProcAddress( hDLL, "Model_Iterate" );
-  if ( modelIterate != NULL ) {
-    mIterate= modelIterate( ptr_toModel );
+  if ( module -> entries.modelIterate != NULL ) {
+    mIterate= module -> entries.modelIterate( ptr_toModel );
     printLIS_( "ModelIterate: %i\n", mIterate );
-    showErrorIfAny( mIterate );
+    showErrorIfAny( ctx, mIterate );
   } 
 
-
-
-  int32_T mTerminate;
-  ModelTerminate modelTerminate= ( ModelTerminate ) GetProcAddress( hDLL, "Model_Terminate" );
-  // if ( modelTerminate != NULL ) {
-  //   mTerminate= modelTerminate( ptr_toModel );
-  //   printLIS_( "ModelTerminate: %i\n", mTerminate );
-  //   showErrorIfAny( mTerminate );
-  // } 
-
   
 
   // _________________________________________________________________________________________________________________________________
 
 
 
-  int32_T modelInit= modelInitialize( ptr_toModel );
+  int32_T modelInit= module -> entries.modelInitialize( ptr_toModel );
   printLIS_( "ModelInit: %i\n", modelInit );        
-  showErrorIfAny( modelInit );
+  showErrorIfAny( ctx, modelInit );
+
+  settleModel( ctx, xout_ar );
+
+  saveCheckpoint( ctx, t );
+
+  dllLogFlush();                                                                                              // Safe point: ATP has not started stepping
 
-  
-    
 }
 
 
 
 void dll_one_m__( double xdata_ar[], double xin_ar[], double xout_ar[], double xvar_ar[] ) {  
 
-  int32_T i;
-  real64_T t= ( real64_T ) xin_ar[ sizeInputs + sizeOutputs ];                          // Simulation Time
-  ptr_toModel->Time= t;
+  ( void ) xvar_ar;                                                           // Part of the FOREIGN call ( Fortran ABI ), the states were bound in 'dll_one_i'
+  DllInstance *ctx= findInstance( xdata_ar );
+  DllModule *module= ctx -> module;
+  IEEE_Cigre_DLLInterface_Instance *ptr_toModel= ctx -> ptr_toModel;
 
-  if ( t >= nextTimeStepDLL ) {
+  real64_T t= ( real64_T ) xin_ar[ ctx -> timeIndex ];                                  // Simulation Time
+  ptr_toModel->Time= t + ctx -> timeOffset;                                              // Model time, ahead of ATP after a checkpoint
 
-    if ( TRelease > 0 && t <= TRelease) {      
+  RateClock *clock= ctx -> rateGroup -> clock;
+  advanceTick( clock, t );
 
-      // Update the instance at each 'nextTimeStepDLL'
-      changeDataType( xin_ar, inputsTypes, inputsOffsets, sizeInputs, ptr_toModel -> ExternalInputs );
+  if ( ctx -> rateGroup -> dueTick == clock -> tick && ctx -> lastTick != clock -> tick ) {
 
-      int32_T modelInit= modelInitialize( ptr_toModel );
-      showErrorIfAny( modelInit );
+    ctx -> lastTick= clock -> tick;
 
-      int32_T modelOut= modelOutputs( ptr_toModel );
-      showErrorIfAny( modelOut );
+    if ( ctx -> TRelease > 0 && t <= ctx -> TRelease) {      
 
+      // Re-initialize only when the held inputs change, the outputs stay in the own buffer while held
+      holdOutputs( ctx, xin_ar, xout_ar );
+
+      if ( ctx -> recorder != NULL ) recordStep( ctx, ctx -> initialOutputs );
+
+      if ( ctx -> subSteps > 1 ) {
+        memcpy( ctx -> prevInputs, xin_ar, ctx -> inputs -> numValues * sizeof( double ) );                     // Subcycling starts from the last held inputs
+      }
+
+    } else if ( ctx -> subSteps > 1 && t > ctx -> startTime + 0.5 * ctx -> timeStep ) {
+
+      subcycleOutputs( ctx, xin_ar, xout_ar, t );
 
     } else {        
 
-      // Update the instance at each 'nextTimeStepDLL'      
-      changeDataType( xin_ar, inputsTypes, inputsOffsets, sizeInputs, ptr_toModel -> ExternalInputs );
+      // Update the instance every 'ticksPerCall' ATP steps
+      bindInputs( ctx, xin_ar );
+      bindOutputs( ctx, xout_ar );
 
-      int32_T modelOut= modelOutputs( ptr_toModel );
-      showErrorIfAny( modelOut );
+      int32_T modelOut= module -> entries.modelOutputs( ptr_toModel );
+      showErrorIfAny( ctx, modelOut );
 
       // Return the model's outputs values to ATP
-      writeValuesToATP( ptr_toModel -> ExternalOutputs, outputsTypes, outputsOffsets, sizeOutputs, xout_ar );
+      returnOutputs( ctx, xout_ar );
+
+      if ( ctx -> rmsIterations > 0 ) {
+        iterateRMS( ctx, xout_ar );
+      }
+
+      if ( ctx -> recorder != NULL ) recordStep( ctx, NULL );
+
+      if ( ctx -> subSteps > 1 ) {
+        memcpy( ctx -> prevInputs, xin_ar, ctx -> inputs -> numValues * sizeof( double ) );                     // A call at the initialization time has no step to subcycle over
+      }
 
     }  
-      
-    nextTimeStepDLL += timeStepDLL;
+
+    if ( ctx -> checkpointPending ) {
+      saveCheckpoint( ctx, t );
+    }
 
   }
 
+  dllLogFlush();                                                                                              // Warnings of this step reach the '.LIS' file before ATP moves on
+
 }
@@ -0,0 +1,70 @@
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include "dll_one_arena.h"
+
+
+// New chunk with at least 'size' usable bytes, the current one unless 'dedicated' ( kept behind the current chunk )
+static DllArenaChunk* newChunk( DllArena *arena, size_t size, int dedicated ) {
+
+  DllArenaChunk *chunk= malloc( sizeof( DllArenaChunk ) );
+  if ( chunk == NULL ) return NULL;
+
+  chunk -> raw= malloc( size + DLL_ARENA_ALIGN );
+  if ( chunk -> raw == NULL ) {
+    free( chunk );
+    return NULL;
+  }
+
+  chunk -> base= ( char * )( ( ( uintptr_t ) chunk -> raw + DLL_ARENA_ALIGN - 1 ) & ~( uintptr_t )( DLL_ARENA_ALIGN - 1 ) );
+  chunk -> size= size;
+  chunk -> used= 0;
+
+  if ( dedicated && arena -> chunks != NULL ) {
+    chunk -> next= arena -> chunks -> next;
+    arena -> chunks -> next= chunk;
+  } else {
+    chunk -> next= arena -> chunks;
+    arena -> chunks= chunk;
+  }
+
+  return chunk;
+
+}
+
+void* arenaAlloc( DllArena *arena, size_t size ) {
+
+  size_t rounded= ( size + DLL_ARENA_ALIGN - 1 ) & ~( size_t )( DLL_ARENA_ALIGN - 1 );
+  if ( rounded == 0 ) rounded= DLL_ARENA_ALIGN;
+
+  DllArenaChunk *chunk= arena -> chunks;
+
+  if ( rounded > DLL_ARENA_CHUNK / 4 ) {
+    chunk= newChunk( arena, rounded, 1 );                                                                   // Large blocks do not retire the current chunk
+    if ( chunk == NULL ) return NULL;
+  } else if ( chunk == NULL || chunk -> used + rounded > chunk -> size ) {
+    chunk= newChunk( arena, DLL_ARENA_CHUNK, 0 );                                                           // Leftover of the old chunk is not reused
+    if ( chunk == NULL ) return NULL;
+  }
+
+  void *ptr= chunk -> base + chunk -> used;
+  chunk -> used += rounded;
+  arena -> allocated += rounded;
+
+  memset( ptr, 0, rounded );
+  return ptr;
+
+}
+
+void arenaRelease( DllArena *arena ) {
+
+  while ( arena -> chunks != NULL ) {
+    DllArenaChunk *chunk= arena -> chunks;
+    arena -> chunks= chunk -> next;
+    free( chunk -> raw );
+    free( chunk );
+  }
+
+  arena -> allocated= 0;
+
+}
@@ -0,0 +1,41 @@
+/*
+File: dll_one_arena.h
+
+Bump allocator for the per-instance data of the wrapper. Every allocation is carved, zeroed and cache-line aligned,
+from large chunks, so the instance struct, its port layouts and its value buffers created by one 'dll_one_i' call sit
+in one contiguous slab. Nothing is freed individually: the whole arena is released at the end of the simulation.
+*/
+#ifndef __dll_one_arena__
+#define __dll_one_arena__
+
+#include <stddef.h>
+
+
+#define DLL_ARENA_ALIGN 64                                    // Cache line
+#define DLL_ARENA_CHUNK ( 64 * 1024 )                         // Default chunk size (bytes), larger requests get their own chunk
+
+
+typedef struct _DllArenaChunk
+{
+    struct _DllArenaChunk * next;
+    void *      raw;            // Block returned by 'malloc'
+    char *      base;           // First aligned byte
+    size_t      size;           // Usable bytes from 'base'
+    size_t      used;           // Bytes already carved
+} DllArenaChunk;
+
+typedef struct _DllArena
+{
+    DllArenaChunk * chunks;     // Current chunk first
+    size_t      allocated;      // Bytes carved, for reporting
+} DllArena;
+
+
+// Zeroed, DLL_ARENA_ALIGN aligned block of 'size' bytes, NULL if out of memory
+void* arenaAlloc( DllArena *arena, size_t size );
+
+// Release every chunk of the arena
+void arenaRelease( DllArena *arena );
+
+
+#endif /* __dll_one_arena__ */
@@ -0,0 +1,619 @@
+#include <string.h>
+#include <limits.h>
+#include "dll_one_convert.h"
+
+#if defined( __GNUC__ ) && ( defined( __x86_64__ ) || defined( __i386__ ) )
+#define DLL_CONVERT_X86
+#include <immintrin.h>
+#endif
+
+// 32-bit Windows callers ( ATP itself ) keep the stack only 4-byte aligned: the vector kernels realign it on entry, as
+// -mstackrealign would, before they spill 16 or 32-byte registers
+#if defined( _WIN32 ) && defined( __i386__ )
+#define DLL_CONVERT_KERNEL( isa ) __attribute__(( target( isa ), force_align_arg_pointer ))
+#else
+#define DLL_CONVERT_KERNEL( isa ) __attribute__(( target( isa ) ))
+#endif
+
+
+// ______________________________________________________________________________________________________________________
+// Scalar kernels, also used for the tail of the vectorized ones
+
+static void int8ToModel_scalar( const double *src, void *dst, int32_T count ) {
+  int8_T *val= ( int8_T * ) dst;
+  int32_T k;
+  for ( k= 0; k < count; k++ ) val[k]= ( int8_T )( int32_T )( src[k] );
+}
+
+static void uint8ToModel_scalar( const double *src, void *dst, int32_T count ) {
+  uint8_T *val= ( uint8_T * ) dst;
+  int32_T k;
+  for ( k= 0; k < count; k++ ) val[k]= ( uint8_T )( int32_T )( src[k] );
+}
+
+static void int16ToModel_scalar( const double *src, void *dst, int32_T count ) {
+  int16_T *val= ( int16_T * ) dst;
+  int32_T k;
+  for ( k= 0; k < count; k++ ) val[k]= ( int16_T )( int32_T )( src[k] );
+}
+
+static void uint16ToModel_scalar( const double *src, void *dst, int32_T count ) {
+  uint16_T *val= ( uint16_T * ) dst;
+  int32_T k;
+  for ( k= 0; k < count; k++ ) val[k]= ( uint16_T )( int32_T )( src[k] );
+}
+
+static void int32ToModel_scalar( const double *src, void *dst, int32_T count ) {
+  int32_T *val= ( int32_T * ) dst;
+  int32_T k;
+  for ( k= 0; k < count; k++ ) val[k]= ( int32_T )( src[k] );
+}
+
+static void uint32ToModel_scalar( const double *src, void *dst, int32_T count ) {
+  uint32_T *val= ( uint32_T * ) dst;
+  int32_T k;
+  for ( k= 0; k < count; k++ ) val[k]= ( src[k] >= 2147483648.0 ) ? ( uint32_T )( int32_T )( src[k] - 2147483648.0 ) ^ 0x80000000u : ( uint32_T )( int32_T )( src[k] );
+}
+
+static void real32ToModel_scalar( const double *src, void *dst, int32_T count ) {
+  real32_T *val= ( real32_T * ) dst;
+  int32_T k;
+  for ( k= 0; k < count; k++ ) val[k]= ( real32_T )( src[k] );
+}
+
+static void real64ToModel( const double *src, void *dst, int32_T count ) {
+  memcpy( dst, src, count * sizeof( real64_T ) );                                                                                      // Same representation as ATP
+}
+
+static void int8ToATP_scalar( const void *src, double *dst, int32_T count ) {
+  const int8_T *val= ( const int8_T * ) src;
+  int32_T k;
+  for ( k= 0; k < count; k++ ) dst[k]= ( double ) val[k];
+}
+
+static void uint8ToATP_scalar( const void *src, double *dst, int32_T count ) {
+  const uint8_T *val= ( const uint8_T * ) src;
+  int32_T k;
+  for ( k= 0; k < count; k++ ) dst[k]= ( double ) val[k];
+}
+
+static void int16ToATP_scalar( const void *src, double *dst, int32_T count ) {
+  const int16_T *val= ( const int16_T * ) src;
+  int32_T k;
+  for ( k= 0; k < count; k++ ) dst[k]= ( double ) val[k];
+}
+
+static void uint16ToATP_scalar( const void *src, double *dst, int32_T count ) {
+  const uint16_T *val= ( const uint16_T * ) src;
+  int32_T k;
+  for ( k= 0; k < count; k++ ) dst[k]= ( double ) val[k];
+}
+
+static void int32ToATP_scalar( const void *src, double *dst, int32_T count ) {
+  const int32_T *val= ( const int32_T * ) src;
+  int32_T k;
+  for ( k= 0; k < count; k++ ) dst[k]= ( double ) val[k];
+}
+
+static void uint32ToATP_scalar( const void *src, double *dst, int32_T count ) {
+  const uint32_T *val= ( const uint32_T * ) src;
+  int32_T k;
+  for ( k= 0; k < count; k++ ) dst[k]= ( double ) val[k];
+}
+
+static void real32ToATP_scalar( const void *src, double *dst, int32_T count ) {
+  const real32_T *val= ( const real32_T * ) src;
+  int32_T k;
+  for ( k= 0; k < count; k++ ) dst[k]= ( double ) val[k];
+}
+
+static void real64ToATP( const void *src, double *dst, int32_T count ) {
+  memcpy( dst, src, count * sizeof( real64_T ) );
+}
+
+
+#ifdef DLL_CONVERT_X86
+
+// ______________________________________________________________________________________________________________________
+// SSE2 kernels
+
+// Four 'double' truncated to four 'int32_T'
+DLL_CONVERT_KERNEL( "sse2" )
+static inline __m128i truncate4_sse2( const double *src ) {
+  return _mm_unpacklo_epi64( _mm_cvttpd_epi32( _mm_loadu_pd( src ) ), _mm_cvttpd_epi32( _mm_loadu_pd( src + 2 ) ) );
+}
+
+// Four 'double' to four 'uint32_T': values from 2^31 are shifted down before the signed conversion
+DLL_CONVERT_KERNEL( "sse2" )
+static inline __m128i truncate4u_sse2( const double *src ) {
+
+  const __m128d two31= _mm_set1_pd( 2147483648.0 );
+  __m128d lo= _mm_loadu_pd( src ), hi= _mm_loadu_pd( src + 2 );
+  __m128d mlo= _mm_cmpge_pd( lo, two31 ), mhi= _mm_cmpge_pd( hi, two31 );
+
+  __m128i v= _mm_unpacklo_epi64( _mm_cvttpd_epi32( _mm_sub_pd( lo, _mm_and_pd( mlo, two31 ) ) ),
+                                 _mm_cvttpd_epi32( _mm_sub_pd( hi, _mm_and_pd( mhi, two31 ) ) ) );
+  __m128i m= _mm_unpacklo_epi64( _mm_shuffle_epi32( _mm_castpd_si128( mlo ), _MM_SHUFFLE( 2, 0, 2, 0 ) ),
+                                 _mm_shuffle_epi32( _mm_castpd_si128( mhi ), _MM_SHUFFLE( 2, 0, 2, 0 ) ) );
+
+  return _mm_xor_si128( v, _mm_and_si128( m, _mm_set1_epi32( ( int ) 0x80000000u ) ) );
+}
+
+DLL_CONVERT_KERNEL( "sse2" )
+static void int8ToModel_sse2( const double *src, void *dst, int32_T count ) {
+
+  int8_T *val= ( int8_T * ) dst;
+  int32_T k= 0;
+
+  for ( ; k + 16 <= count; k += 16 ) {
+    __m128i v0= _mm_srai_epi32( _mm_slli_epi32( truncate4_sse2( src + k ), 24 ), 24 );                                                 // Keep the low byte, sign extended, so the packs do not saturate
+    __m128i v1= _mm_srai_epi32( _mm_slli_epi32( truncate4_sse2( src + k + 4 ), 24 ), 24 );
+    __m128i v2= _mm_srai_epi32( _mm_slli_epi32( truncate4_sse2( src + k + 8 ), 24 ), 24 );
+    __m128i v3= _mm_srai_epi32( _mm_slli_epi32( truncate4_sse2( src + k + 12 ), 24 ), 24 );
+    _mm_storeu_si128( ( __m128i * )( val + k ), _mm_packs_epi16( _mm_packs_epi32( v0, v1 ), _mm_packs_epi32( v2, v3 ) ) );
+  }
+
+  int8ToModel_scalar( src + k, val + k, count - k );
+}
+
+DLL_CONVERT_KERNEL( "sse2" )
+static void int16ToModel_sse2( const double *src, void *dst, int32_T count ) {
+
+  int16_T *val= ( int16_T * ) dst;
+  int32_T k= 0;
+
+  for ( ; k + 8 <= count; k += 8 ) {
+    __m128i v0= _mm_srai_epi32( _mm_slli_epi32( truncate4_sse2( src + k ), 16 ), 16 );                                                 // Keep the low 16 bits, sign extended
+    __m128i v1= _mm_srai_epi32( _mm_slli_epi32( truncate4_sse2( src + k + 4 ), 16 ), 16 );
+    _mm_storeu_si128( ( __m128i * )( val + k ), _mm_packs_epi32( v0, v1 ) );
+  }
+
+  int16ToModel_scalar( src + k, val + k, count - k );
+}
+
+DLL_CONVERT_KERNEL( "sse2" )
+static void int32ToModel_sse2( const double *src, void *dst, int32_T count ) {
+
+  int32_T *val= ( int32_T * ) dst;
+  int32_T k= 0;
+
+  for ( ; k + 4 <= count; k += 4 ) {
+    _mm_storeu_si128( ( __m128i * )( val + k ), truncate4_sse2( src + k ) );
+  }
+
+  int32ToModel_scalar( src + k, val + k, count - k );
+}
+
+DLL_CONVERT_KERNEL( "sse2" )
+static void uint32ToModel_sse2( const double *src, void *dst, int32_T count ) {
+
+  uint32_T *val= ( uint32_T * ) dst;
+  int32_T k= 0;
+
+  for ( ; k + 4 <= count; k += 4 ) {
+    _mm_storeu_si128( ( __m128i * )( val + k ), truncate4u_sse2( src + k ) );
+  }
+
+  uint32ToModel_scalar( src + k, val + k, count - k );
+}
+
+DLL_CONVERT_KERNEL( "sse2" )
+static void real32ToModel_sse2( const double *src, void *dst, int32_T count ) {
+
+  real32_T *val= ( real32_T * ) dst;
+  int32_T k= 0;
+
+  for ( ; k + 4 <= count; k += 4 ) {
+    _mm_storeu_ps( val + k, _mm_movelh_ps( _mm_cvtpd_ps( _mm_loadu_pd( src + k ) ), _mm_cvtpd_ps( _mm_loadu_pd( src + k + 2 ) ) ) );
+  }
+
+  real32ToModel_scalar( src + k, val + k, count - k );
+}
+
+DLL_CONVERT_KERNEL( "sse2" )
+static inline void store4_sse2( double *dst, __m128i v ) {
+  _mm_storeu_pd( dst, _mm_cvtepi32_pd( v ) );
+  _mm_storeu_pd( dst + 2, _mm_cvtepi32_pd( _mm_shuffle_epi32( v, _MM_SHUFFLE( 1, 0, 3, 2 ) ) ) );
+}
+
+DLL_CONVERT_KERNEL( "sse2" )
+static void int8ToATP_sse2( const void *src, double *dst, int32_T count ) {
+
+  const int8_T *val= ( const int8_T * ) src;
+  int32_T k= 0;
+
+  for ( ; k + 16 <= count; k += 16 ) {
+    __m128i b= _mm_loadu_si128( ( const __m128i * )( val + k ) );
+    __m128i lo= _mm_srai_epi16( _mm_unpacklo_epi8( b, b ), 8 );
+    __m128i hi= _mm_srai_epi16( _mm_unpackhi_epi8( b, b ), 8 );
+    store4_sse2( dst + k, _mm_srai_epi32( _mm_unpacklo_epi16( lo, lo ), 16 ) );
+    store4_sse2( dst + k + 4, _mm_srai_epi32( _mm_unpackhi_epi16( lo, lo ), 16 ) );
+    store4_sse2( dst + k + 8, _mm_srai_epi32( _mm_unpacklo_epi16( hi, hi ), 16 ) );
+    store4_sse2( dst + k + 12, _mm_srai_epi32( _mm_unpackhi_epi16( hi, hi ), 16 ) );
+  }
+
+  int8ToATP_scalar( val + k, dst + k, count - k );
+}
+
+DLL_CONVERT_KERNEL( "sse2" )
+static void uint8ToATP_sse2( const void *src, double *dst, int32_T count ) {
+
+  const uint8_T *val= ( const uint8_T * ) src;
+  const __m128i zero= _mm_setzero_si128();
+  int32_T k= 0;
+
+  for ( ; k + 16 <= count; k += 16 ) {
+    __m128i b= _mm_loadu_si128( ( const __m128i * )( val + k ) );
+    __m128i lo= _mm_unpacklo_epi8( b, zero );
+    __m128i hi= _mm_unpackhi_epi8( b, zero );
+    store4_sse2( dst + k, _mm_unpacklo_epi16( lo, zero ) );
+    store4_sse2( dst + k + 4, _mm_unpackhi_epi16( lo, zero ) );
+    store4_sse2( dst + k + 8, _mm_unpacklo_epi16( hi, zero ) );
+    store4_sse2( dst + k + 12, _mm_unpackhi_epi16( hi, zero ) );
+  }
+
+  uint8ToATP_scalar( val + k, dst + k, count - k );
+}
+
+DLL_CONVERT_KERNEL( "sse2" )
+static void int16ToATP_sse2( const void *src, double *dst, int32_T count ) {
+
+  const int16_T *val= ( const int16_T * ) src;
+  int32_T k= 0;
+
+  for ( ; k + 8 <= count; k += 8 ) {
+    __m128i h= _mm_loadu_si128( ( const __m128i * )( val + k ) );
+    store4_sse2( dst + k, _mm_srai_epi32( _mm_unpacklo_epi16( h, h ), 16 ) );
+    store4_sse2( dst + k + 4, _mm_srai_epi32( _mm_unpackhi_epi16( h, h ), 16 ) );
+  }
+
+  int16ToATP_scalar( val + k, dst + k, count - k );
+}
+
+DLL_CONVERT_KERNEL( "sse2" )
+static void uint16ToATP_sse2( const void *src, double *dst, int32_T count ) {
+
+  const uint16_T *val= ( const uint16_T * ) src;
+  const __m128i zero= _mm_setzero_si128();
+  int32_T k= 0;
+
+  for ( ; k + 8 <= count; k += 8 ) {
+    __m128i h= _mm_loadu_si128( ( const __m128i * )( val + k ) );
+    store4_sse2( dst + k, _mm_unpacklo_epi16( h, zero ) );
+    store4_sse2( dst + k + 4, _mm_unpackhi_epi16( h, zero ) );
+  }
+
+  uint16ToATP_scalar( val + k, dst + k, count - k );
+}
+
+DLL_CONVERT_KERNEL( "sse2" )
+static void int32ToATP_sse2( const void *src, double *dst, int32_T count ) {
+
+  const int32_T *val= ( const int32_T * ) src;
+  int32_T k= 0;
+
+  for ( ; k + 4 <= count; k += 4 ) {
+    store4_sse2( dst + k, _mm_loadu_si128( ( const __m128i * )( val + k ) ) );
+  }
+
+  int32ToATP_scalar( val + k, dst + k, count - k );
+}
+
+DLL_CONVERT_KERNEL( "sse2" )
+static void uint32ToATP_sse2( const void *src, double *dst, int32_T count ) {
+
+  const uint32_T *val= ( const uint32_T * ) src;
+  const __m128d two32= _mm_set1_pd( 4294967296.0 ), zero= _mm_setzero_pd();
+  int32_T k= 0;
+
+  for ( ; k + 4 <= count; k += 4 ) {
+    __m128i v= _mm_loadu_si128( ( const __m128i * )( val + k ) );
+    __m128d lo= _mm_cvtepi32_pd( v );                                                                                                  // Signed conversion, values from 2^31 come out negative
+    __m128d hi= _mm_cvtepi32_pd( _mm_shuffle_epi32( v, _MM_SHUFFLE( 1, 0, 3, 2 ) ) );
+    _mm_storeu_pd( dst + k, _mm_add_pd( lo, _mm_and_pd( _mm_cmplt_pd( lo, zero ), two32 ) ) );
+    _mm_storeu_pd( dst + k + 2, _mm_add_pd( hi, _mm_and_pd( _mm_cmplt_pd( hi, zero ), two32 ) ) );
+  }
+
+  uint32ToATP_scalar( val + k, dst + k, count - k );
+}
+
+DLL_CONVERT_KERNEL( "sse2" )
+static void real32ToATP_sse2( const void *src, double *dst, int32_T count ) {
+
+  const real32_T *val= ( const real32_T * ) src;
+  int32_T k= 0;
+
+  for ( ; k + 4 <= count; k += 4 ) {
+    __m128 f= _mm_loadu_ps( val + k );
+    _mm_storeu_pd( dst + k, _mm_cvtps_pd( f ) );
+    _mm_storeu_pd( dst + k + 2, _mm_cvtps_pd( _mm_movehl_ps( f, f ) ) );
+  }
+
+  real32ToATP_scalar( val + k, dst + k, count - k );
+}
+
+
+// ______________________________________________________________________________________________________________________
+// AVX2 kernels, four 'double' per conversion instruction
+
+DLL_CONVERT_KERNEL( "avx2" )
+static void int8ToModel_avx2( const double *src, void *dst, int32_T count ) {
+
+  int8_T *val= ( int8_T * ) dst;
+  int32_T k= 0;
+
+  for ( ; k + 16 <= count; k += 16 ) {
+    __m128i v0= _mm_srai_epi32( _mm_slli_epi32( _mm256_cvttpd_epi32( _mm256_loadu_pd( src + k ) ), 24 ), 24 );
+    __m128i v1= _mm_srai_epi32( _mm_slli_epi32( _mm256_cvttpd_epi32( _mm256_loadu_pd( src + k + 4 ) ), 24 ), 24 );
+    __m128i v2= _mm_srai_epi32( _mm_slli_epi32( _mm256_cvttpd_epi32( _mm256_loadu_pd( src + k + 8 ) ), 24 ), 24 );
+    __m128i v3= _mm_srai_epi32( _mm_slli_epi32( _mm256_cvttpd_epi32( _mm256_loadu_pd( src + k + 12 ) ), 24 ), 24 );
+    _mm_storeu_si128( ( __m128i * )( val + k ), _mm_packs_epi16( _mm_packs_epi32( v0, v1 ), _mm_packs_epi32( v2, v3 ) ) );
+  }
+
+  int8ToModel_scalar( src + k, val + k, count - k );
+}
+
+DLL_CONVERT_KERNEL( "avx2" )
+static void int16ToModel_avx2( const double *src, void *dst, int32_T count ) {
+
+  int16_T *val= ( int16_T * ) dst;
+  int32_T k= 0;
+
+  for ( ; k + 16 <= count; k += 16 ) {
+    __m256i v0= _mm256_set_m128i( _mm256_cvttpd_epi32( _mm256_loadu_pd( src + k + 4 ) ), _mm256_cvttpd_epi32( _mm256_loadu_pd( src + k ) ) );
+    __m256i v1= _mm256_set_m128i( _mm256_cvttpd_epi32( _mm256_loadu_pd( src + k + 12 ) ), _mm256_cvttpd_epi32( _mm256_loadu_pd( src + k + 8 ) ) );
+    v0= _mm256_srai_epi32( _mm256_slli_epi32( v0, 16 ), 16 );
+    v1= _mm256_srai_epi32( _mm256_slli_epi32( v1, 16 ), 16 );
+    __m256i p= _mm256_permute4x64_epi64( _mm256_packs_epi32( v0, v1 ), _MM_SHUFFLE( 3, 1, 2, 0 ) );                                    // The pack works per 128-bit lane
+    _mm256_storeu_si256( ( __m256i * )( val + k ), p );
+  }
+
+  int16ToModel_sse2( src + k, val + k, count - k );
+}
+
+DLL_CONVERT_KERNEL( "avx2" )
+static void int32ToModel_avx2( const double *src, void *dst, int32_T count ) {
+
+  int32_T *val= ( int32_T * ) dst;
+  int32_T k= 0;
+
+  for ( ; k + 8 <= count; k += 8 ) {
+    _mm_storeu_si128( ( __m128i * )( val + k ), _mm256_cvttpd_epi32( _mm256_loadu_pd( src + k ) ) );
+    _mm_storeu_si128( ( __m128i * )( val + k + 4 ), _mm256_cvttpd_epi32( _mm256_loadu_pd( src + k + 4 ) ) );
+  }
+
+  int32ToModel_scalar( src + k, val + k, count - k );
+}
+
+DLL_CONVERT_KERNEL( "avx2" )
+static void real32ToModel_avx2( const double *src, void *dst, int32_T count ) {
+
+  real32_T *val= ( real32_T * ) dst;
+  int32_T k= 0;
+
+  for ( ; k + 8 <= count; k += 8 ) {
+    _mm_storeu_ps( val + k, _mm256_cvtpd_ps( _mm256_loadu_pd( src + k ) ) );
+    _mm_storeu_ps( val + k + 4, _mm256_cvtpd_ps( _mm256_loadu_pd( src + k + 4 ) ) );
+  }
+
+  real32ToModel_scalar( src + k, val + k, count - k );
+}
+
+DLL_CONVERT_KERNEL( "avx2" )
+static void int8ToATP_avx2( const void *src, double *dst, int32_T count ) {
+
+  const int8_T *val= ( const int8_T * ) src;
+  int32_T k= 0;
+
+  for ( ; k + 8 <= count; k += 8 ) {
+    __m256i v= _mm256_cvtepi8_epi32( _mm_loadl_epi64( ( const __m128i * )( val + k ) ) );
+    _mm256_storeu_pd( dst + k, _mm256_cvtepi32_pd( _mm256_castsi256_si128( v ) ) );
+    _mm256_storeu_pd( dst + k + 4, _mm256_cvtepi32_pd( _mm256_extracti128_si256( v, 1 ) ) );
+  }
+
+  int8ToATP_scalar( val + k, dst + k, count - k );
+}
+
+DLL_CONVERT_KERNEL( "avx2" )
+static void uint8ToATP_avx2( const void *src, double *dst, int32_T count ) {
+
+  const uint8_T *val= ( const uint8_T * ) src;
+  int32_T k= 0;
+
+  for ( ; k + 8 <= count; k += 8 ) {
+    __m256i v= _mm256_cvtepu8_epi32( _mm_loadl_epi64( ( const __m128i * )( val + k ) ) );
+    _mm256_storeu_pd( dst + k, _mm256_cvtepi32_pd( _mm256_castsi256_si128( v ) ) );
+    _mm256_storeu_pd( dst + k + 4, _mm256_cvtepi32_pd( _mm256_extracti128_si256( v, 1 ) ) );
+  }
+
+  uint8ToATP_scalar( val + k, dst + k, count - k );
+}
+
+DLL_CONVERT_KERNEL( "avx2" )
+static void int16ToATP_avx2( const void *src, double *dst, int32_T count ) {
+
+  const int16_T *val= ( const int16_T * ) src;
+  int32_T k= 0;
+
+  for ( ; k + 8 <= count; k += 8 ) {
+    __m256i v= _mm256_cvtepi16_epi32( _mm_loadu_si128( ( const __m128i * )( val + k ) ) );
+    _mm256_storeu_pd( dst + k, _mm256_cvtepi32_pd( _mm256_castsi256_si128( v ) ) );
+    _mm256_storeu_pd( dst + k + 4, _mm256_cvtepi32_pd( _mm256_extracti128_si256( v, 1 ) ) );
+  }
+
+  int16ToATP_scalar( val + k, dst + k, count - k );
+}
+
+DLL_CONVERT_KERNEL( "avx2" )
+static void uint16ToATP_avx2( const void *src, double *dst, int32_T count ) {
+
+  const uint16_T *val= ( const uint16_T * ) src;
+  int32_T k= 0;
+
+  for ( ; k + 8 <= count; k += 8 ) {
+    __m256i v= _mm256_cvtepu16_epi32( _mm_loadu_si128( ( const __m128i * )( val + k ) ) );
+    _mm256_storeu_pd( dst + k, _mm256_cvtepi32_pd( _mm256_castsi256_si128( v ) ) );
+    _mm256_storeu_pd( dst + k + 4, _mm256_cvtepi32_pd( _mm256_extracti128_si256( v, 1 ) ) );
+  }
+
+  uint16ToATP_scalar( val + k, dst + k, count - k );
+}
+
+DLL_CONVERT_KERNEL( "avx2" )
+static void int32ToATP_avx2( const void *src, double *dst, int32_T count ) {
+
+  const int32_T *val= ( const int32_T * ) src;
+  int32_T k= 0;
+
+  for ( ; k + 4 <= count; k += 4 ) {
+    _mm256_storeu_pd( dst + k, _mm256_cvtepi32_pd( _mm_loadu_si128( ( const __m128i * )( val + k ) ) ) );
+  }
+
+  int32ToATP_scalar( val + k, dst + k, count - k );
+}
+
+DLL_CONVERT_KERNEL( "avx2" )
+static void real32ToATP_avx2( const void *src, double *dst, int32_T count ) {
+
+  const real32_T *val= ( const real32_T * ) src;
+  int32_T k= 0;
+
+  for ( ; k + 4 <= count; k += 4 ) {
+    _mm256_storeu_pd( dst + k, _mm256_cvtps_pd( _mm_loadu_ps( val + k ) ) );
+  }
+
+  real32ToATP_scalar( val + k, dst + k, count - k );
+}
+
+#endif /* DLL_CONVERT_X86 */
+
+
+// ______________________________________________________________________________________________________________________
+// Kernel tables, indexed by IEEE_Cigre_DLLInterface_DataType and filled once
+
+#define DLL_CONVERT_TYPES ( IEEE_Cigre_DLLInterface_DataType_c_string_T + 1 )
+
+static DllToModelKernel toModelKernels[ DLL_CONVERT_TYPES ];
+static DllToATPKernel toATPKernels[ DLL_CONVERT_TYPES ];
+static const char *kernelsName;
+
+
+// Fill the tables with the kernels of 'level' ( 0: scalar, 1: SSE2, 2: AVX2 ) or of the best level below it the processor
+// supports, returns the level used
+static int32_T selectKernels( int32_T level ) {
+
+  int32_T used= 0;
+
+  toModelKernels[ IEEE_Cigre_DLLInterface_DataType_int8_T ]= int8ToModel_scalar;
+  toModelKernels[ IEEE_Cigre_DLLInterface_DataType_uint8_T ]= uint8ToModel_scalar;
+  toModelKernels[ IEEE_Cigre_DLLInterface_DataType_int16_T ]= int16ToModel_scalar;
+  toModelKernels[ IEEE_Cigre_DLLInterface_DataType_uint16_T ]= uint16ToModel_scalar;
+  toModelKernels[ IEEE_Cigre_DLLInterface_DataType_int32_T ]= int32ToModel_scalar;
+  toModelKernels[ IEEE_Cigre_DLLInterface_DataType_uint32_T ]= uint32ToModel_scalar;
+  toModelKernels[ IEEE_Cigre_DLLInterface_DataType_real32_T ]= real32ToModel_scalar;
+  toModelKernels[ IEEE_Cigre_DLLInterface_DataType_real64_T ]= real64ToModel;
+
+  toATPKernels[ IEEE_Cigre_DLLInterface_DataType_int8_T ]= int8ToATP_scalar;
+  toATPKernels[ IEEE_Cigre_DLLInterface_DataType_uint8_T ]= uint8ToATP_scalar;
+  toATPKernels[ IEEE_Cigre_DLLInterface_DataType_int16_T ]= int16ToATP_scalar;
+  toATPKernels[ IEEE_Cigre_DLLInterface_DataType_uint16_T ]= uint16ToATP_scalar;
+  toATPKernels[ IEEE_Cigre_DLLInterface_DataType_int32_T ]= int32ToATP_scalar;
+  toATPKernels[ IEEE_Cigre_DLLInterface_DataType_uint32_T ]= uint32ToATP_scalar;
+  toATPKernels[ IEEE_Cigre_DLLInterface_DataType_real32_T ]= real32ToATP_scalar;
+  toATPKernels[ IEEE_Cigre_DLLInterface_DataType_real64_T ]= real64ToATP;
+
+  kernelsName= "scalar";
+
+#ifdef DLL_CONVERT_X86
+  __builtin_cpu_init();
+
+  if ( level >= 1 && __builtin_cpu_supports( "sse2" ) ) {
+
+    toModelKernels[ IEEE_Cigre_DLLInterface_DataType_int8_T ]= int8ToModel_sse2;
+    toModelKernels[ IEEE_Cigre_DLLInterface_DataType_uint8_T ]= int8ToModel_sse2;                                                     // Same low byte as the signed kernel
+    toModelKernels[ IEEE_Cigre_DLLInterface_DataType_int16_T ]= int16ToModel_sse2;
+    toModelKernels[ IEEE_Cigre_DLLInterface_DataType_uint16_T ]= int16ToModel_sse2;                                                   // Same low 16 bits as the signed kernel
+    toModelKernels[ IEEE_Cigre_DLLInterface_DataType_int32_T ]= int32ToModel_sse2;
+    toModelKernels[ IEEE_Cigre_DLLInterface_DataType_uint32_T ]= uint32ToModel_sse2;
+    toModelKernels[ IEEE_Cigre_DLLInterface_DataType_real32_T ]= real32ToModel_sse2;
+
+    toATPKernels[ IEEE_Cigre_DLLInterface_DataType_int8_T ]= int8ToATP_sse2;
+    toATPKernels[ IEEE_Cigre_DLLInterface_DataType_uint8_T ]= uint8ToATP_sse2;
+    toATPKernels[ IEEE_Cigre_DLLInterface_DataType_int16_T ]= int16ToATP_sse2;
+    toATPKernels[ IEEE_Cigre_DLLInterface_DataType_uint16_T ]= uint16ToATP_sse2;
+    toATPKernels[ IEEE_Cigre_DLLInterface_DataType_int32_T ]= int32ToATP_sse2;
+    toATPKernels[ IEEE_Cigre_DLLInterface_DataType_uint32_T ]= uint32ToATP_sse2;
+    toATPKernels[ IEEE_Cigre_DLLInterface_DataType_real32_T ]= real32ToATP_sse2;
+
+    kernelsName= "sse2";
+    used= 1;
+  }
+
+  if ( level >= 2 && __builtin_cpu_supports( "avx2" ) ) {
+
+    toModelKernels[ IEEE_Cigre_DLLInterface_DataType_int8_T ]= int8ToModel_avx2;
+    toModelKernels[ IEEE_Cigre_DLLInterface_DataType_uint8_T ]= int8ToModel_avx2;
+    toModelKernels[ IEEE_Cigre_DLLInterface_DataType_int16_T ]= int16ToModel_avx2;
+    toModelKernels[ IEEE_Cigre_DLLInterface_DataType_uint16_T ]= int16ToModel_avx2;
+    toModelKernels[ IEEE_Cigre_DLLInterface_DataType_int32_T ]= int32ToModel_avx2;
+    toModelKernels[ IEEE_Cigre_DLLInterface_DataType_real32_T ]= real32ToModel_avx2;
+
+    toATPKernels[ IEEE_Cigre_DLLInterface_DataType_int8_T ]= int8ToATP_avx2;
+    toATPKernels[ IEEE_Cigre_DLLInterface_DataType_uint8_T ]= uint8ToATP_avx2;
+    toATPKernels[ IEEE_Cigre_DLLInterface_DataType_int16_T ]= int16ToATP_avx2;
+    toATPKernels[ IEEE_Cigre_DLLInterface_DataType_uint16_T ]= uint16ToATP_avx2;
+    toATPKernels[ IEEE_Cigre_DLLInterface_DataType_int32_T ]= int32ToATP_avx2;
+    toATPKernels[ IEEE_Cigre_DLLInterface_DataType_real32_T ]= real32ToATP_avx2;
+
+    kernelsName= "avx2";
+    used= 2;
+  }
+#else
+  ( void ) level;
+#endif
+
+  // 'char_T' is a plain 'char', its signedness follows the compiler
+  toModelKernels[ IEEE_Cigre_DLLInterface_DataType_char_T ]= ( CHAR_MIN < 0 ) ? toModelKernels[ IEEE_Cigre_DLLInterface_DataType_int8_T ] : toModelKernels[ IEEE_Cigre_DLLInterface_DataType_uint8_T ];
+  toATPKernels[ IEEE_Cigre_DLLInterface_DataType_char_T ]= ( CHAR_MIN < 0 ) ? toATPKernels[ IEEE_Cigre_DLLInterface_DataType_int8_T ] : toATPKernels[ IEEE_Cigre_DLLInterface_DataType_uint8_T ];
+
+  return used;
+
+}
+
+
+DllToModelKernel toModelKernel( int32_T type ) {
+
+  if ( kernelsName == NULL ) selectKernels( 2 );
+  if ( type < 0 || type >= DLL_CONVERT_TYPES ) return NULL;
+
+  return toModelKernels[ type ];
+
+}
+
+DllToATPKernel toATPKernel( int32_T type ) {
+
+  if ( kernelsName == NULL ) selectKernels( 2 );
+  if ( type < 0 || type >= DLL_CONVERT_TYPES ) return NULL;
+
+  return toATPKernels[ type ];
+
+}
+
+const char *convertKernelsName( void ) {
+
+  if ( kernelsName == NULL ) selectKernels( 2 );
+  return kernelsName;
+
+}
+
+int32_T useConvertKernels( const char *name ) {
+
+  int32_T level= ( strcmp( name, "avx2" ) == 0 ) ? 2 : ( strcmp( name, "sse2" ) == 0 ) ? 1 : ( strcmp( name, "scalar" ) == 0 ) ? 0 : -1;
+  if ( level < 0 ) return 0;
+
+  if ( selectKernels( level ) == level ) return 1;
+
+  selectKernels( 2 );                                                                                                                  // Not supported: back to the fastest ones
+  return 0;
+
+}
@@ -0,0 +1,37 @@
+/*
+File: dll_one_convert.h
+
+Conversion kernels between the ATP 'double' arrays and the typed buffers of an IEEE/Cigre model, one pair per
+IEEE_Cigre_DLLInterface_DataType.
+
+On x86 the kernels are vectorized with SSE2 and, when the processor supports it, AVX2; the remaining values are
+converted by a scalar tail. Every kernel gives the same result as the scalar casts: 'double' values are truncated
+toward zero to 'int32_T' and integer types narrower than 32 bits keep the low bits of that value.
+*/
+#ifndef __dll_one_convert__
+#define __dll_one_convert__
+
+#include "IEEE_Cigre_DLLInterface.h"
+
+
+// ATP 'double' array -> 'count' values of the model data type
+typedef void ( *DllToModelKernel )( const double *src, void *dst, int32_T count );
+
+// 'count' values of the model data type -> ATP 'double' array
+typedef void ( *DllToATPKernel )( const void *src, double *dst, int32_T count );
+
+
+// Fastest kernels the processor supports for a data type, NULL if the type cannot be marshalled
+DllToModelKernel toModelKernel( int32_T type );
+DllToATPKernel toATPKernel( int32_T type );
+
+// Instruction set the kernels were selected for: "avx2", "sse2" or "scalar"
+const char *convertKernelsName( void );
+
+// Use the kernels of one instruction set ( "scalar", "sse2" or "avx2" ) instead of the fastest ones, for the kernel check
+// ( convert_check ). Returns 0, keeping the fastest kernels, when the processor lacks it. Layouts built before keep the
+// kernels they were built with
+int32_T useConvertKernels( const char *name );
+
+
+#endif /* __dll_one_convert__ */
@@ -0,0 +1,202 @@
+/*
+File: dll_one_driver.c
+
+Drives dll_one.c the way ATP does, without tpbig: the wrapper is linked with the stand-in runtime ( atp_stub.c ) and
+loads the model through the Linux loader backend ( dll_one_loader.h ). Every instance is initialized with 'dll_one_i'
+and then stepped with 'dll_one_m' at the ATP time step, with the '.LIS' output captured in memory.
+
+Usage:
+  dll_one_driver <dll_list> <dllIndex> [instances] [tEnd] [timeStep] [lisFile] [inputs]
+
+The 'xdata' of every instance holds the dll index, the default parameters of the model, the time step and
+TRelease= 0. The inputs are the comma-separated 'inputs' values ( one per input value, default 0 ) held for the whole
+run, the initial outputs are 0. 'timeStep' defaults to the model's FixedStepBaseSampleTime and
+'tEnd' to 1000 steps. The '.LIS' lines are also written to 'lisFile' when given.
+
+Build: make dll_one_driver
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "IEEE_Cigre_DLLInterface.h"
+#include "dll_one_run.h"
+#include "atp_stub.h"
+
+
+void dll_one_i__( double xdata_ar[], double xin_ar[], double xout_ar[], double xvar_ar[] );
+void dll_one_m__( double xdata_ar[], double xin_ar[], double xout_ar[], double xvar_ar[] );
+void dll_one_t__( void );
+
+
+// The MODELS arrays of one 'USE ... FOREIGN dll_one'
+typedef struct _DriverInstance {
+  double *xdata;
+  double *xin;
+  double *xout;
+  double *xvar;
+} DriverInstance;
+
+
+// Line 'dllIndex' ( 1-based ) of the dll list, as dll_one reads it
+static void readListEntry( const char *listPath, int dllIndex, char *entry, size_t size ) {
+
+  FILE *pFile= fopen( listPath, "r" );
+  if ( pFile == NULL ) hostFail( "Could not read dll list: ", listPath );
+
+  int n= 0;
+  while ( fgets( entry, ( int ) size, pFile ) != NULL ) {
+
+    entry[ strcspn( entry, "\r\n" ) ]= '\0';
+    if ( entry[0] == '\0' ) continue;
+
+    if ( ++n == dllIndex ) {
+
+      char *end= strchr( entry, '|' );                                                                   // 'path | options'
+      if ( end == NULL ) end= entry + strlen( entry );
+      while ( end > entry && ( end[-1] == ' ' || end[-1] == '\t' ) ) end--;
+      *end= '\0';
+
+      fclose( pFile );
+      return;
+    }
+  }
+
+  fclose( pFile );
+  hostFail( "Dll index out of the list range: ", listPath );
+
+}
+
+static double elapsedNs( const struct timespec *t0, const struct timespec *t1 ) {
+  return ( t1 -> tv_sec - t0 -> tv_sec ) * 1e9 + ( t1 -> tv_nsec - t0 -> tv_nsec );
+}
+
+
+int main( int argc, char *argv[] ) {
+
+  if ( argc < 3 ) {
+    printf( "Usage: %s <dll_list> <dllIndex> [instances] [tEnd] [timeStep] [lisFile] [inputs]\n", argv[0] );
+    return EXIT_FAILURE;
+  }
+
+  const char *listPath= argv[1];
+  int dllIndex= atoi( argv[2] );
+  int numInstances= ( argc > 3 ) ? atoi( argv[3] ) : 1;
+
+  if ( numInstances < 1 ) hostFail( "Invalid number of instances: ", argv[3] );
+
+  FILE *lisFile= NULL;
+  if ( argc > 6 && argv[6][0] != '\0' ) {
+    lisFile= fopen( argv[6], "w" );
+    if ( lisFile == NULL ) hostFail( "Cannot write ", argv[6] );
+    atpStubEcho( lisFile );
+  }
+
+  setenv( "DLL_ONE_LIST", listPath, 1 );                                                                     // dll_one reads the same list
+
+
+  // Size the MODELS arrays from the model information, as create_MODELS_C does
+
+  char entry[4096];
+  readListEntry( listPath, dllIndex, entry, sizeof( entry ) );
+
+  ModelRun run;                                                                                              // Same entry points and layouts as dll_one
+  memset( &run, 0, sizeof( run ) );
+  loadModelRun( &run, entry );
+
+  IEEE_Cigre_DLLInterface_Model_Info *modelInfo= run.modelInfo;
+
+  int32_T valuesInputs= run.inputs.numValues;
+  int32_T valuesOutputs= run.outputs.numValues;
+  int32_T sizeParams= modelInfo -> NumParameters;
+  const DllStateLayout *states= &run.states;
+
+  double timeStep= ( argc > 5 ) ? atof( argv[5] ) : modelInfo -> FixedStepBaseSampleTime;
+  double tEnd= ( argc > 4 ) ? atof( argv[4] ) : 1000 * timeStep;
+  long numSteps= ( long )( tEnd / timeStep + 0.5 );
+
+  if ( timeStep <= 0 ) hostFail( "Invalid time step", NULL );
+
+  DriverInstance *instances= calloc( numInstances, sizeof( DriverInstance ) );
+  if ( instances == NULL ) hostFail( "Memory allocation failed for the instances", NULL );
+
+  int i, k;
+  for ( i= 0; i < numInstances; i++ ) {
+
+    DriverInstance *inst= &instances[i];
+    inst -> xdata= calloc( sizeParams + 3, sizeof( double ) );
+    inst -> xin= calloc( valuesInputs + valuesOutputs + 1, sizeof( double ) );
+    inst -> xout= calloc( valuesOutputs + 1, sizeof( double ) );
+    inst -> xvar= calloc( states -> numSlots + 1, sizeof( double ) );                                      // Never empty
+
+    if ( inst -> xdata == NULL || inst -> xin == NULL || inst -> xout == NULL || inst -> xvar == NULL ) {
+      hostFail( "Memory allocation failed for the instances", NULL );
+    }
+
+    inst -> xdata[0]= dllIndex;
+    for ( k= 0; k < sizeParams; k++ ) {
+      inst -> xdata[ 1 + k ]= defaultParameter( &modelInfo -> ParametersInfo[k] );
+    }
+    inst -> xdata[ 1 + sizeParams ]= timeStep;
+    inst -> xdata[ 2 + sizeParams ]= 0;                                                                    // TRelease
+
+    if ( argc > 7 ) {
+
+      char *values= argv[7];
+      for ( k= 0; k < valuesInputs && *values != '\0'; k++ ) {
+        inst -> xin[k]= strtod( values, &values );
+        if ( *values == ',' ) values++;
+      }
+
+      if ( k < valuesInputs || *values != '\0' ) hostFail( "The inputs must have one value per model input value: ", argv[7] );
+    }
+  }
+
+  printf( "Model= %s - %d instances - TimeStep= %g - %ld steps\n", modelInfo -> ModelName, numInstances, timeStep, numSteps );
+
+
+  // Initialization and time loop, a 'stoptp_' call comes back here
+
+  if ( ATP_STUB_TRY() != 0 ) {
+    printf( "Simulation stopped: %s\n", atpStubStopMessage() );
+    return EXIT_FAILURE;
+  }
+
+  struct timespec t0, t1, t2;
+  clock_gettime( CLOCK_MONOTONIC, &t0 );
+
+  for ( i= 0; i < numInstances; i++ ) {
+    dll_one_i__( instances[i].xdata, instances[i].xin, instances[i].xout, instances[i].xvar );
+  }
+
+  clock_gettime( CLOCK_MONOTONIC, &t1 );
+
+  long n;
+  int32_T timeIndex= valuesInputs + valuesOutputs;
+
+  for ( n= 1; n <= numSteps; n++ ) {
+
+    double t= n * timeStep;
+
+    for ( i= 0; i < numInstances; i++ ) {
+      instances[i].xin[ timeIndex ]= t;
+      dll_one_m__( instances[i].xdata, instances[i].xin, instances[i].xout, instances[i].xvar );
+    }
+  }
+
+  clock_gettime( CLOCK_MONOTONIC, &t2 );
+
+  dll_one_t__();                                                                                             // End of the simulation: Model_Terminate and the reports
+
+  double calls= ( double ) numSteps * numInstances;
+
+  printf( "Init= %.3f ms ( %.1f us per instance )\n", elapsedNs( &t0, &t1 ) / 1e6, elapsedNs( &t0, &t1 ) / 1e3 / numInstances );
+  printf( "Steps= %.3f ms ( %.1f ns per dll_one_m call )\n", elapsedNs( &t1, &t2 ) / 1e6, calls > 0 ? elapsedNs( &t1, &t2 ) / calls : 0 );
+  printf( "LIS lines= %ld\n", atpStubLines() );
+  printf( "Outputs[1]=" );
+  for ( k= 0; k < valuesOutputs; k++ ) printf( " %.6g", instances[0].xout[k] );
+  printf( "\n" );
+
+  return EXIT_SUCCESS;
+
+}
@@ -0,0 +1,111 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "dll_one_host.h"
+
+
+// Resolve the entry points of a loaded dll, returns the name of the first required one missing ( NULL: all found )
+const char* resolveModelEntries( HMODULE hDLL, DllModelEntries *entries ) {
+
+  entries -> getInfo= ( GetInfo ) GetProcAddress( hDLL, "Model_GetInfo" );
+  entries -> modelFirstCall= ( ModelCall ) GetProcAddress( hDLL, "Model_FirstCall" );
+  entries -> checkParameters= ( ModelCall ) GetProcAddress( hDLL, "Model_CheckParameters" );
+  entries -> modelInitialize= ( ModelCall ) GetProcAddress( hDLL, "Model_Initialize" );
+  entries -> modelOutputs= ( ModelCall ) GetProcAddress( hDLL, "Model_Outputs" );
+  entries -> modelIterate= ( ModelCall ) GetProcAddress( hDLL, "Model_Iterate" );
+  entries -> modelTerminate= ( ModelCall ) GetProcAddress( hDLL, "Model_Terminate" );
+  entries -> modelSetLogSink= ( ModelSetLogSink ) GetProcAddress( hDLL, "Model_SetLogSink" );
+
+  if ( entries -> getInfo == NULL ) return "Model_GetInfo";
+  if ( entries -> checkParameters == NULL ) return "Model_CheckParameters";
+  if ( entries -> modelInitialize == NULL ) return "Model_Initialize";
+  if ( entries -> modelOutputs == NULL ) return "Model_Outputs";
+
+  return NULL;
+
+}
+
+// Name of port 'i' of the 'Inputs', 'Parameters' or 'Outputs' ports, for the messages
+const char* modelPortName( const char *label, const IEEE_Cigre_DLLInterface_Model_Info *modelInfo, int32_T i ) {
+
+  if ( strcmp( label, "Inputs" ) == 0 ) {
+    return ( const char * ) modelInfo -> InputPortsInfo[i].Name;
+  } else if ( strcmp( label, "Outputs" ) == 0 ) {
+    return ( const char * ) modelInfo -> OutputPortsInfo[i].Name;
+  }
+
+  return ( const char * ) modelInfo -> ParametersInfo[i].Name;
+
+}
+
+// Data type of port 'i' of the 'Inputs', 'Parameters' or 'Outputs' ports
+int32_T modelPortType( const char *label, const IEEE_Cigre_DLLInterface_Model_Info *modelInfo, int32_T i ) {
+
+  if ( strcmp( label, "Inputs" ) == 0 ) {
+    return ( int32_T ) modelInfo -> InputPortsInfo[i].DataType;
+  } else if ( strcmp( label, "Outputs" ) == 0 ) {
+    return ( int32_T ) modelInfo -> OutputPortsInfo[i].DataType;
+  }
+
+  return ( int32_T ) modelInfo -> ParametersInfo[i].DataType;
+
+}
+
+// Lay out the ports of one kind from the static model information
+int32_T buildModelLayout( const char *label, const IEEE_Cigre_DLLInterface_Model_Info *modelInfo, DllPortLayout *layout ) {
+
+  int32_T size;
+  const IEEE_Cigre_DLLInterface_Signal *signals= NULL;
+
+  if ( strcmp( label, "Inputs" ) == 0 ) {
+    size= modelInfo -> NumInputPorts;
+    signals= modelInfo -> InputPortsInfo;
+  } else if ( strcmp( label, "Outputs" ) == 0 ) {
+    size= modelInfo -> NumOutputPorts;
+    signals= modelInfo -> OutputPortsInfo;
+  } else {
+    size= modelInfo -> NumParameters;
+  }
+
+  int32_T *types= malloc( ( size > 0 ? size : 1 ) * sizeof( int32_T ) );
+  int32_T *widths= malloc( ( size > 0 ? size : 1 ) * sizeof( int32_T ) );
+
+  if ( types == NULL || widths == NULL ) {
+    free( types );
+    free( widths );
+    return DLL_LAYOUT_NO_MEMORY;
+  }
+
+  int32_T i;
+  for ( i= 0; i < size; i++ ) {
+    types[i]= modelPortType( label, modelInfo, i );
+    widths[i]= ( signals != NULL ) ? portWidth( signals[i] ) : 1;                                       // Only scalar parameters are allowed
+  }
+
+  // Offsets and conversion plan, reused at every step
+  int32_T status= buildPortLayout( layout, size, types, widths, NULL );
+
+  free( types );
+  free( widths );
+
+  return status;
+
+}
+
+// Default value of a parameter as a 'double'
+double defaultParameter( const IEEE_Cigre_DLLInterface_Parameter *param ) {
+
+  switch ( param -> DataType ) {
+    case IEEE_Cigre_DLLInterface_DataType_char_T: return param -> DefaultValue.Char_Val;
+    case IEEE_Cigre_DLLInterface_DataType_int8_T: return param -> DefaultValue.Int8_Val;
+    case IEEE_Cigre_DLLInterface_DataType_uint8_T: return param -> DefaultValue.Uint8_Val;
+    case IEEE_Cigre_DLLInterface_DataType_int16_T: return param -> DefaultValue.Int16_Val;
+    case IEEE_Cigre_DLLInterface_DataType_uint16_T: return param -> DefaultValue.Uint16_Val;
+    case IEEE_Cigre_DLLInterface_DataType_int32_T: return param -> DefaultValue.Int32_Val;
+    case IEEE_Cigre_DLLInterface_DataType_uint32_T: return param -> DefaultValue.Uint32_Val;
+    case IEEE_Cigre_DLLInterface_DataType_real32_T: return param -> DefaultValue.Real32_Val;
+    case IEEE_Cigre_DLLInterface_DataType_real64_T: return param -> DefaultValue.Real64_Val;
+    default: return 0;
+  }
+
+}
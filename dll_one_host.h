@@ -0,0 +1,55 @@
+/*
+File: dll_one_host.h
+
+Host side of a model dll, shared by dll_one.c and the standalone Linux tools ( dll_one_driver, model_runner,
+contingency_fork ): the entry points of the dll, the port layouts built from its Model_Info and the default
+parameters. 'dll_one_i' builds every module through these functions, so the tools see a model exactly as ATP does.
+The tools' own side is in dll_one_run.h.
+*/
+#ifndef __dll_one_host__
+#define __dll_one_host__
+
+#include "IEEE_Cigre_DLLInterface.h"
+#ifndef IEEE_Cigre_DLLInterface_Log_Host
+#define IEEE_Cigre_DLLInterface_Log_Host                                      // Only the sink types, not the model helpers
+#endif
+#include "IEEE_Cigre_DLLInterface_Log.h"
+#include "dll_one_layout.h"
+#include "dll_one_loader.h"
+
+
+typedef IEEE_Cigre_DLLInterface_Model_Info* ( *GetInfo )( void );
+typedef int32_T ( *ModelCall )( IEEE_Cigre_DLLInterface_Instance* instance );
+typedef int32_T ( *ModelSetLogSink )( IEEE_Cigre_DLLInterface_LogSink sink, void *context, int32_T level );
+
+
+// Entry points of a model dll
+typedef struct _DllModelEntries
+{
+    GetInfo     getInfo;
+    ModelCall   modelFirstCall;         // Optional
+    ModelCall   checkParameters;
+    ModelCall   modelInitialize;
+    ModelCall   modelOutputs;
+    ModelCall   modelIterate;           // Optional
+    ModelCall   modelTerminate;         // Optional
+    ModelSetLogSink modelSetLogSink;    // Optional, logging extension
+} DllModelEntries;
+
+
+// Resolve the entry points of a loaded dll, returns the name of the first required one missing ( NULL: all found )
+const char* resolveModelEntries( HMODULE hDLL, DllModelEntries *entries );
+
+// Name and data type of port 'i' of the 'Inputs', 'Parameters' or 'Outputs' ports, for the messages
+const char* modelPortName( const char *label, const IEEE_Cigre_DLLInterface_Model_Info *modelInfo, int32_T i );
+int32_T modelPortType( const char *label, const IEEE_Cigre_DLLInterface_Model_Info *modelInfo, int32_T i );
+
+// Lay out the 'Inputs', 'Parameters' or 'Outputs' ports of a model ( parameters are scalars ), returns the status of
+// buildPortLayout
+int32_T buildModelLayout( const char *label, const IEEE_Cigre_DLLInterface_Model_Info *modelInfo, DllPortLayout *layout );
+
+// Default value of a parameter as a 'double'
+double defaultParameter( const IEEE_Cigre_DLLInterface_Parameter *param );
+
+
+#endif /* __dll_one_host__ */
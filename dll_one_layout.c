@@ -0,0 +1,165 @@
+#include <stdlib.h>
+#include <string.h>
+#include "dll_one_layout.h"
+
+
+// Size in bytes of a data type, 0 if the type cannot be marshalled
+size_t dataTypeSize( int32_T type ) {
+
+  switch ( type ) {
+    case IEEE_Cigre_DLLInterface_DataType_char_T: return sizeof( char_T );
+    case IEEE_Cigre_DLLInterface_DataType_int8_T: return sizeof( int8_T );
+    case IEEE_Cigre_DLLInterface_DataType_uint8_T: return sizeof( uint8_T );
+    case IEEE_Cigre_DLLInterface_DataType_int16_T: return sizeof( int16_T );
+    case IEEE_Cigre_DLLInterface_DataType_uint16_T: return sizeof( uint16_T );
+    case IEEE_Cigre_DLLInterface_DataType_int32_T: return sizeof( int32_T );
+    case IEEE_Cigre_DLLInterface_DataType_uint32_T: return sizeof( uint32_T );
+    case IEEE_Cigre_DLLInterface_DataType_real32_T: return sizeof( real32_T );
+    case IEEE_Cigre_DLLInterface_DataType_real64_T: return sizeof( real64_T );
+    // case IEEE_Cigre_DLLInterface_DataType_c_string_T: return sizeof( '\0' );
+  }
+
+  return 0;
+
+}
+
+// Compute the amount of memory to reserve depending on the data type, width and number of 'Inputs', 'Outputs', and 'Parameters' the DLL model needs
+static void getAlignmentSizeAndOffset( int32_T type, int32_T width, size_t *currentOffset, size_t *offsets, int32_T i ) {
+
+  size_t alignment= dataTypeSize( type );
+
+  size_t remainder= *currentOffset % alignment;
+  if ( remainder != 0 ) *currentOffset += ( alignment - remainder );                                                                     // If ( remainder != 0 ),  currentOffset remains the same
+
+  offsets[i]= *currentOffset;
+
+  *currentOffset += alignment * width;                                                                                                   // Array ports are stored as one contiguous block
+
+}
+
+// Number of ATP values taken by 'size' signals ( sum of their widths )
+int32_T signalValues( const IEEE_Cigre_DLLInterface_Signal *signals, int32_T size ) {
+
+  int32_T i, values= 0;
+
+  for ( i= 0; i < size; i++ ) {
+    values += portWidth( signals[i] );
+  }
+
+  return values;
+
+}
+
+static void* layoutAlloc( DllArena *arena, size_t size ) {
+  return ( arena != NULL ) ? arenaAlloc( arena, size ) : malloc( size );
+}
+
+// Lay out the ports and group consecutive ports of the same type into runs
+int32_T buildPortLayout( DllPortLayout *layout, int32_T size, const int32_T *types, const int32_T *widths, DllArena *arena ) {
+
+  int32_T i;
+
+  memset( layout, 0, sizeof( DllPortLayout ) );
+
+  for ( i= 0; i < size; i++ ) {
+    if ( dataTypeSize( types[i] ) == 0 ) return i;
+  }
+
+  layout -> size= size;
+  layout -> inArena= ( arena != NULL );
+  layout -> runs= layoutAlloc( arena, ( size > 0 ? size : 1 ) * sizeof( DllPortRun ) );                                                  // The plan first, it is what every step reads
+  layout -> types= layoutAlloc( arena, ( size > 0 ? size : 1 ) * sizeof( int32_T ) );
+  layout -> widths= layoutAlloc( arena, ( size > 0 ? size : 1 ) * sizeof( int32_T ) );
+  layout -> first= layoutAlloc( arena, ( size > 0 ? size : 1 ) * sizeof( int32_T ) );
+  layout -> offsets= layoutAlloc( arena, ( size > 0 ? size : 1 ) * sizeof( size_t ) );
+
+  if ( layout -> types == NULL || layout -> widths == NULL || layout -> first == NULL || layout -> offsets == NULL || layout -> runs == NULL ) {
+    freePortLayout( layout );
+    return DLL_LAYOUT_NO_MEMORY;
+  }
+
+  for ( i= 0; i < size; i++ ) {
+    layout -> types[i]= types[i];
+    layout -> widths[i]= ( widths != NULL && widths[i] > 1 ) ? widths[i] : 1;
+    layout -> first[i]= layout -> numValues;
+    layout -> numValues += layout -> widths[i];
+    getAlignmentSizeAndOffset( types[i], layout -> widths[i], &layout -> totalSize, layout -> offsets, i );
+  }
+
+  // Same type and back to back in the model buffer: extend the current run
+  DllPortRun *run= NULL;
+
+  for ( i= 0; i < size; i++ ) {
+
+    size_t typeSize= dataTypeSize( types[i] );
+
+    if ( run != NULL && run -> type == types[i] && run -> offset + run -> count * typeSize == layout -> offsets[i] ) {
+      run -> count += layout -> widths[i];
+      continue;
+    }
+
+    run= &layout -> runs[ layout -> numRuns++ ];
+    run -> type= types[i];
+    run -> first= layout -> first[i];
+    run -> count= layout -> widths[i];
+    run -> offset= layout -> offsets[i];
+    run -> toModel= toModelKernel( types[i] );
+    run -> toATP= toATPKernel( types[i] );
+
+  }
+
+  // A single real64_T run starting at byte 0 has exactly the layout of the ATP array
+  layout -> zeroCopy= ( layout -> numRuns == 1 && layout -> runs[0].type == IEEE_Cigre_DLLInterface_DataType_real64_T && layout -> runs[0].offset == 0 );
+
+  return DLL_LAYOUT_OK;
+
+}
+
+void freePortLayout( DllPortLayout *layout ) {
+
+  if ( !layout -> inArena ) {
+    free( layout -> types );
+    free( layout -> widths );
+    free( layout -> first );
+    free( layout -> offsets );
+    free( layout -> runs );
+  }
+
+  memset( layout, 0, sizeof( DllPortLayout ) );
+
+}
+
+void buildStateLayout( DllStateLayout *layout, int32_T numIntStates, int32_T numFloatStates, int32_T numDoubleStates ) {
+
+  layout -> intOffset= 0;
+  layout -> floatOffset= numIntStates * sizeof( int32_T );                                                                               // Same alignment, no padding
+  layout -> doubleOffset= layout -> floatOffset + numFloatStates * sizeof( real32_T );
+  layout -> doubleOffset= ( layout -> doubleOffset + sizeof( real64_T ) - 1 ) & ~( sizeof( real64_T ) - 1 );
+  layout -> totalSize= layout -> doubleOffset + numDoubleStates * sizeof( real64_T );
+  layout -> numSlots= ( int32_T )( ( layout -> totalSize + sizeof( double ) - 1 ) / sizeof( double ) );
+
+}
+
+// Assign the data type to a vector based on a structure coming from the dll model
+void changeDataType( const double *valuesFromATP, const DllPortLayout *layout, void *valuesToModel ) {
+
+  int32_T r;
+
+  for ( r= 0; r < layout -> numRuns; r++ ) {
+    const DllPortRun *run= &layout -> runs[r];
+    run -> toModel( valuesFromATP + run -> first, ( uint8_T * ) valuesToModel + run -> offset, run -> count );
+  }
+
+}
+
+// Return back the values to ATP in 'double' data type
+void writeValuesToATP( const void *valuesFromModel, const DllPortLayout *layout, double *valuesToATP ) {
+
+  int32_T r;
+
+  for ( r= 0; r < layout -> numRuns; r++ ) {
+    const DllPortRun *run= &layout -> runs[r];
+    run -> toATP( ( const uint8_T * ) valuesFromModel + run -> offset, valuesToATP + run -> first, run -> count );
+  }
+
+}
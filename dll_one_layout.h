@@ -0,0 +1,87 @@
+/*
+File: dll_one_layout.h
+
+Port layouts of the 'Inputs', 'Outputs' and 'Parameters' buffers handed to an IEEE/Cigre model, and the conversion
+plan used to move values between them and the ATP 'double' arrays.
+
+The plan is compiled once at initialization: consecutive ports with the same data type are merged into runs, so every
+step costs one 'memcpy' or one vectorized conversion kernel ( dll_one_convert.h ) per run instead of a type switch
+per port.
+*/
+#ifndef __dll_one_layout__
+#define __dll_one_layout__
+
+#include <stddef.h>
+#include "IEEE_Cigre_DLLInterface.h"
+#include "dll_one_convert.h"
+#include "dll_one_arena.h"
+
+
+// Consecutive ports with the same data type, stored back to back in the model buffer
+typedef struct _DllPortRun
+{
+    int32_T     type;           // IEEE_Cigre_DLLInterface_DataType of every value in the run
+    int32_T     first;          // Index of the first value in the ATP array
+    int32_T     count;          // Number of values ( array ports contribute 'Width' values )
+    size_t      offset;         // Byte offset of the first value in the model buffer
+    DllToModelKernel toModel;   // ATP -> model buffer conversion of the run
+    DllToATPKernel   toATP;     // Model buffer -> ATP conversion of the run
+} DllPortRun;
+
+// Layout of one model buffer and its conversion plan
+typedef struct _DllPortLayout
+{
+    int32_T     size;           // Number of ports
+    int32_T     numValues;      // Number of values in the ATP array ( sum of the port widths )
+    int32_T *   types;          // Data type of every port
+    int32_T *   widths;         // Array dimension of every port
+    int32_T *   first;          // Index of the first value of every port in the ATP array
+    size_t *    offsets;        // Byte offset of every port in the model buffer
+    size_t      totalSize;      // Size of the model buffer (bytes)
+    int32_T     numRuns;        // Number of runs in the plan
+    DllPortRun *runs;           // Conversion plan
+    int32_T     zeroCopy;       // 1 if the buffer is byte-identical to the ATP 'double' array (every port real64_T)
+    int32_T     inArena;        // 1 if the arrays were carved from an arena ( released with it )
+} DllPortLayout;
+
+
+// Byte layout of the model states in the ATP 'xvar' array: the int and float states packed back to back, the double
+// states from the next 8-byte boundary
+typedef struct _DllStateLayout
+{
+    size_t      intOffset;      // Byte offset of the int32_T states
+    size_t      floatOffset;    // Byte offset of the real32_T states
+    size_t      doubleOffset;   // Byte offset of the real64_T states
+    size_t      totalSize;      // Bytes taken by every state
+    int32_T     numSlots;       // 'double' slots of 'xvar' covering 'totalSize'
+} DllStateLayout;
+
+
+// Size in bytes of a data type, 0 if the type cannot be marshalled
+size_t dataTypeSize( int32_T type );
+
+#define DLL_LAYOUT_OK -1
+#define DLL_LAYOUT_NO_MEMORY -2
+
+// Array dimension of a signal, scalars may declare a 'Width' of 0 or 1
+#define portWidth( signal ) ( ( signal ).Width > 1 ? ( signal ).Width : 1 )
+
+// Number of ATP values taken by 'size' signals ( sum of their widths )
+int32_T signalValues( const IEEE_Cigre_DLLInterface_Signal *signals, int32_T size );
+
+// Lay out 'size' ports of the given types and widths ( NULL: all scalars ) and compile the plan, the arrays come from
+// 'arena' ( NULL: malloc ); returns DLL_LAYOUT_OK, DLL_LAYOUT_NO_MEMORY or the index of the first unsupported port
+int32_T buildPortLayout( DllPortLayout *layout, int32_T size, const int32_T *types, const int32_T *widths, DllArena *arena );
+void freePortLayout( DllPortLayout *layout );
+
+// Lay out the states of a model, 'numSlots' is what the MODELS 'ixvar' must reserve
+void buildStateLayout( DllStateLayout *layout, int32_T numIntStates, int32_T numFloatStates, int32_T numDoubleStates );
+
+// ATP -> model buffer
+void changeDataType( const double *valuesFromATP, const DllPortLayout *layout, void *valuesToModel );
+
+// Model buffer -> ATP
+void writeValuesToATP( const void *valuesFromModel, const DllPortLayout *layout, double *valuesToATP );
+
+
+#endif /* __dll_one_layout__ */
@@ -0,0 +1,39 @@
+/*
+File: dll_one_loader.h
+
+Loader backend of the wrapper. On Windows the model dlls are loaded with the Win32 calls themselves; elsewhere the
+same names are mapped onto 'dlopen'/'dlsym', so dll_one.c loads Linux shared objects without any change.
+*/
+#ifndef __dll_one_loader__
+#define __dll_one_loader__
+
+#ifdef _WIN32
+
+#include <windows.h>
+
+#else
+
+#include <dlfcn.h>
+#include <limits.h>
+
+
+#define MAX_PATH PATH_MAX
+
+typedef void* HMODULE;
+
+
+static inline HMODULE LoadLibrary( const char *path ) {
+  return dlopen( path, RTLD_NOW | RTLD_LOCAL );
+}
+
+static inline void* GetProcAddress( HMODULE hModule, const char *name ) {
+  return dlsym( hModule, name );
+}
+
+static inline int FreeLibrary( HMODULE hModule ) {
+  return dlclose( hModule ) == 0;
+}
+
+#endif
+
+#endif /* __dll_one_loader__ */
@@ -0,0 +1,124 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "dll_one_log.h"
+
+
+// One queued message, 'length' bytes of 'text' without the terminating '\0'
+typedef struct _DllLogSlot {
+  int32_T level;
+  int32_T length;
+  char text[ DLL_LOG_LINE ];
+} DllLogSlot;
+
+// Ring of queued messages: 'dllLogV' advances 'head' once a slot is written, the flush advances 'tail' once it is
+// printed. Both only grow, the slot of a position is 'position % DLL_LOG_SLOTS'. ATP calls the wrapper from one
+// thread, so plain loads and stores are enough
+static DllLogSlot logRing[ DLL_LOG_SLOTS ];
+static uint32_T logHead= 0;
+static uint32_T logTail= 0;
+static int32_T logFlushing= 0;
+static uint32_T logDropped= 0;                                                // Messages lost to a full ring during a flush
+
+// Lowest level kept, read once per process ( < 0 until then )
+static int32_T logLevel= -1;
+
+
+void outsix_( char *, int32_T * );
+
+
+static int32_T readLogLevel( void ) {
+
+  const char *level= getenv( DLL_LOG_LEVEL_ENV );
+
+  if ( level == NULL || level[0] == '\0' ) return DLL_LOG_DEBUG;                                               // Every line the wrapper always printed
+  if ( strcmp( level, "info" ) == 0 ) return DLL_LOG_INFO;
+  if ( strcmp( level, "warning" ) == 0 ) return DLL_LOG_WARNING;
+  if ( strcmp( level, "error" ) == 0 ) return DLL_LOG_ERROR;
+
+  return DLL_LOG_DEBUG;
+
+}
+
+int32_T dllLogEnabled( int32_T level ) {
+
+  return level >= dllLogThreshold();
+
+}
+
+int32_T dllLogThreshold( void ) {
+
+  if ( logLevel < 0 ) logLevel= readLogLevel();
+  return logLevel;
+
+}
+
+void dllLogFlush( void ) {
+
+  if ( logFlushing || logTail == logHead ) return;                                                         // 'outsix_' may end up logging
+  logFlushing= 1;
+
+  while ( logTail != logHead ) {                                                                             // Messages queued by 'outsix_' go out too
+    DllLogSlot *slot= &logRing[ logTail % DLL_LOG_SLOTS ];
+    outsix_( slot -> text, &slot -> length );
+    logTail++;
+  }
+
+  if ( logDropped > 0 ) {
+    char text[ 80 ];
+    int32_T length= snprintf( text, sizeof( text ), "Warning: %u log messages dropped ( log full while it was written )", logDropped );
+    logDropped= 0;
+    outsix_( text, &length );
+  }
+
+  logFlushing= 0;
+
+}
+
+void dllLogV( int32_T level, const char *fmt, va_list args ) {
+
+  if ( !dllLogEnabled( level ) ) return;
+
+  if ( logHead - logTail == DLL_LOG_SLOTS ) {
+
+    // Full while it is being written ( 'outsix_' logging ): every slot is still unprinted, drop the message
+    if ( logFlushing ) {
+      logDropped++;
+      return;
+    }
+
+    dllLogFlush();                                                                                           // Full: print the whole ring as one batch
+  }
+
+  uint32_T head= logHead;
+
+  DllLogSlot *slot= &logRing[ head % DLL_LOG_SLOTS ];
+  int length= vsnprintf( slot -> text, DLL_LOG_LINE, fmt, args );
+
+  if ( length < 0 ) {
+    length= 0;
+    slot -> text[0]= '\0';
+  } else if ( length >= DLL_LOG_LINE ) {
+    length= DLL_LOG_LINE - 1;
+    memcpy( slot -> text + length - 3, "...", 3 );                                                         // Mark the truncation
+  }
+
+  slot -> level= level;
+  slot -> length= length;
+  logHead= head + 1;
+
+  if ( level >= DLL_LOG_ERROR ) {
+    dllLogFlush();
+  }
+
+}
+
+void dllLog( int32_T level, const char *fmt, ... ) {
+
+  va_list args;
+
+  va_start( args, fmt );
+  dllLogV( level, fmt, args );
+  va_end( args );
+
+}
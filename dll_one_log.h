@@ -0,0 +1,43 @@
+/*
+File: dll_one_log.h
+
+Buffered '.LIS' logging of the wrapper. A message is formatted once, bounded to DLL_LOG_LINE bytes, into a slot of a
+ring; the slots are handed to the ATP 'outsix_' routine in batches at the safe points ( end of 'dll_one_i', end of a
+'dll_one_m' call that queued messages, end of the simulation, before stopping it ) or when the ring fills up.
+
+Messages below the level set by 'DLL_ONE_LOG_LEVEL' ( debug, info, warning or error; default: debug ) are dropped
+before they are formatted.
+*/
+#ifndef __dll_one_log__
+#define __dll_one_log__
+
+#include <stdarg.h>
+#include "IEEE_Cigre_DLLInterface.h"
+
+
+#define DLL_LOG_DEBUG 0                                       // Port values and other detail
+#define DLL_LOG_INFO 1
+#define DLL_LOG_WARNING 2
+#define DLL_LOG_ERROR 3                                       // Flushed at once
+
+#define DLL_LOG_LEVEL_ENV "DLL_ONE_LOG_LEVEL"
+
+#define DLL_LOG_SLOTS 1024                                    // Ring size ( power of 2 )
+#define DLL_LOG_LINE 512                                      // Longest message (bytes), longer ones are truncated
+
+
+// Queue a message of the given level, formatted as 'printf' does
+void dllLog( int32_T level, const char *fmt, ... );
+void dllLogV( int32_T level, const char *fmt, va_list args );
+
+// 1 if a message of 'level' would be kept, to skip building expensive arguments
+int32_T dllLogEnabled( int32_T level );
+
+// Lowest level kept
+int32_T dllLogThreshold( void );
+
+// Hand every queued message to 'outsix_', returns at once when nothing is queued
+void dllLogFlush( void );
+
+
+#endif /* __dll_one_log__ */
@@ -0,0 +1,191 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include "dll_one_record.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#endif
+
+
+#define DLL_RECORD_GRANULARITY ( 64 * 1024 )                                  // Mapping offsets: Windows allocation granularity, a multiple of the page size
+
+
+struct _DllRecorder {
+#ifdef _WIN32
+  HANDLE hFile;
+  HANDLE hMapping;
+#else
+  int fd;
+#endif
+  uint8_t *view;              // Mapped chunk
+  long long viewOffset;       // File offset of 'view'
+  size_t used;                // Bytes written in 'view'
+  size_t recordSize;
+  long long count;
+  int failed;                 // The file could not grow, later records are dropped
+};
+
+
+// ______________________________________________________________________________________________________________________
+// Mapping backends: map the chunk at 'offset', growing the file to cover it
+
+#ifdef _WIN32
+
+static int mapChunk( DllRecorder *recorder, long long offset ) {
+
+  long long end= offset + DLL_RECORD_CHUNK;
+
+  if ( recorder -> view != NULL ) UnmapViewOfFile( recorder -> view );
+  if ( recorder -> hMapping != NULL ) CloseHandle( recorder -> hMapping );
+  recorder -> view= NULL;
+
+  recorder -> hMapping= CreateFileMapping( recorder -> hFile, NULL, PAGE_READWRITE, ( DWORD )( end >> 32 ), ( DWORD )( end & 0xFFFFFFFF ), NULL );
+  if ( recorder -> hMapping == NULL ) return 0;
+
+  recorder -> view= MapViewOfFile( recorder -> hMapping, FILE_MAP_WRITE, ( DWORD )( offset >> 32 ), ( DWORD )( offset & 0xFFFFFFFF ), DLL_RECORD_CHUNK );
+  recorder -> viewOffset= offset;
+  recorder -> used= 0;
+
+  return recorder -> view != NULL;
+
+}
+
+static void unmapAndTrim( DllRecorder *recorder ) {
+
+  LARGE_INTEGER size;
+  size.QuadPart= recorder -> viewOffset + recorder -> used;
+
+  if ( recorder -> view != NULL ) UnmapViewOfFile( recorder -> view );
+  if ( recorder -> hMapping != NULL ) CloseHandle( recorder -> hMapping );
+
+  SetFilePointerEx( recorder -> hFile, size, NULL, FILE_BEGIN );
+  SetEndOfFile( recorder -> hFile );
+  CloseHandle( recorder -> hFile );
+
+}
+
+static int openFile( DllRecorder *recorder, const char *path ) {
+
+  recorder -> hFile= CreateFile( path, GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL );
+  return recorder -> hFile != INVALID_HANDLE_VALUE;
+
+}
+
+#else
+
+static int mapChunk( DllRecorder *recorder, long long offset ) {
+
+  if ( recorder -> view != NULL ) munmap( recorder -> view, DLL_RECORD_CHUNK );
+  recorder -> view= NULL;
+
+  if ( ftruncate( recorder -> fd, ( off_t )( offset + DLL_RECORD_CHUNK ) ) != 0 ) return 0;
+
+  void *view= mmap( NULL, DLL_RECORD_CHUNK, PROT_READ | PROT_WRITE, MAP_SHARED, recorder -> fd, ( off_t ) offset );
+  if ( view == MAP_FAILED ) return 0;
+
+  recorder -> view= view;
+  recorder -> viewOffset= offset;
+  recorder -> used= 0;
+
+  return 1;
+
+}
+
+static void unmapAndTrim( DllRecorder *recorder ) {
+
+  if ( recorder -> view != NULL ) munmap( recorder -> view, DLL_RECORD_CHUNK );
+
+  if ( ftruncate( recorder -> fd, ( off_t )( recorder -> viewOffset + recorder -> used ) ) != 0 ) {
+    perror( "dll_one recorder" );
+  }
+  close( recorder -> fd );
+
+}
+
+static int openFile( DllRecorder *recorder, const char *path ) {
+
+  recorder -> fd= open( path, O_RDWR | O_CREAT | O_TRUNC, 0644 );
+  return recorder -> fd >= 0;
+
+}
+
+#endif
+
+
+// ______________________________________________________________________________________________________________________
+
+DllRecorder* recorderOpen( const char *path, const DllRecordHeader *header, const void *params ) {
+
+  size_t paramsBytes= dllRecordAlign( ( size_t ) header -> paramsSize );
+  size_t prefix= dllRecordAlign( sizeof( DllRecordHeader ) ) + paramsBytes;
+
+  if ( ( size_t ) header -> recordSize > DLL_RECORD_CHUNK / 2 || prefix > DLL_RECORD_CHUNK / 2 ) return NULL;
+
+  DllRecorder *recorder= calloc( 1, sizeof( DllRecorder ) );
+  if ( recorder == NULL ) return NULL;
+
+  if ( !openFile( recorder, path ) ) {
+    free( recorder );
+    return NULL;
+  }
+
+  recorder -> recordSize= ( size_t ) header -> recordSize;
+
+  if ( !mapChunk( recorder, 0 ) ) {
+    unmapAndTrim( recorder );
+    free( recorder );
+    return NULL;
+  }
+
+  memcpy( recorder -> view, header, sizeof( DllRecordHeader ) );
+  memcpy( recorder -> view + dllRecordAlign( sizeof( DllRecordHeader ) ), params, header -> paramsSize );
+  recorder -> used= prefix;
+
+  return recorder;
+
+}
+
+void* recorderNext( DllRecorder *recorder ) {
+
+  if ( recorder -> failed ) return NULL;
+
+  if ( recorder -> used + recorder -> recordSize > DLL_RECORD_CHUNK ) {
+
+    // Map on from the granularity boundary below the end of the data, the records stay back to back
+    long long end= recorder -> viewOffset + ( long long ) recorder -> used;
+    long long next= end & ~( long long )( DLL_RECORD_GRANULARITY - 1 );
+
+    if ( !mapChunk( recorder, next ) ) {
+      recorder -> failed= 1;
+      recorder -> viewOffset= end;
+      recorder -> used= 0;
+      return NULL;
+    }
+
+    recorder -> used= ( size_t )( end - next );
+  }
+
+  void *slot= recorder -> view + recorder -> used;
+  recorder -> used += recorder -> recordSize;
+  recorder -> count++;
+
+  return slot;
+
+}
+
+long long recorderCount( const DllRecorder *recorder ) {
+  return recorder -> count;
+}
+
+void recorderClose( DllRecorder *recorder ) {
+
+  unmapAndTrim( recorder );
+  free( recorder );
+
+}
@@ -0,0 +1,66 @@
+/*
+File: dll_one_record.h
+
+Binary I/O recorder of the wrapper. One append-only file per recorded instance: a header derived from the model
+information, the instance's parameter block, then one fixed-size record per model call with the time, the marshalled
+'ExternalInputs' and 'ExternalOutputs' blocks and the states, exactly as the model saw them. The file is written
+through a memory mapping that grows in DLL_RECORD_CHUNK steps, so a record costs a few 'memcpy' and no formatting or
+system call; the file is trimmed to the last record when it is closed.
+
+Every section of the file and of a record starts on an 8-byte boundary.
+*/
+#ifndef __dll_one_record__
+#define __dll_one_record__
+
+#include <stddef.h>
+#include "IEEE_Cigre_DLLInterface.h"
+
+
+#define DLL_RECORD_MAGIC "DLL1REC"
+#define DLL_RECORD_VERSION 1
+#define DLL_RECORD_CHUNK ( 16 * 1024 * 1024 )                 // Bytes mapped at a time, a record takes at most half of it
+
+#define dllRecordAlign( size ) ( ( ( size ) + 7 ) & ~( size_t ) 7 )
+
+
+// Start of a record file, followed by 'paramsSize' bytes of parameters ( padded ) and the records
+typedef struct _DllRecordHeader
+{
+    char        magic[8];
+    int32_T     version;
+    int32_T     headerSize;     // sizeof( DllRecordHeader )
+    char        modelName[64];
+    char        modelVersion[32];
+    int32_T     handle;         // Instance handle in dll_one
+    int32_T     numInputPorts;
+    int32_T     numOutputPorts;
+    int32_T     numParameters;
+    int32_T     inputsSize;     // Bytes of the marshalled blocks
+    int32_T     outputsSize;
+    int32_T     paramsSize;
+    int32_T     numIntStates;
+    int32_T     numFloatStates;
+    int32_T     numDoubleStates;
+    int32_T     statesSize;     // Bytes of the packed states ( DllStateLayout )
+    int32_T     recordSize;     // Bytes of one record: time, inputs, outputs and states, each padded to 8 bytes
+    real64_T    sampleTime;     // FixedStepBaseSampleTime of the model
+    real64_T    timeStep;       // ATP time step
+} DllRecordHeader;
+
+typedef struct _DllRecorder DllRecorder;
+
+
+// Create the file with its header and parameter block, NULL if it cannot be created or mapped
+DllRecorder* recorderOpen( const char *path, const DllRecordHeader *header, const void *params );
+
+// Next record slot ( 'recordSize' bytes ), NULL once the file cannot grow any more
+void* recorderNext( DllRecorder *recorder );
+
+// Number of records written
+long long recorderCount( const DllRecorder *recorder );
+
+// Trim the file to the last record and release it
+void recorderClose( DllRecorder *recorder );
+
+
+#endif /* __dll_one_record__ */
@@ -0,0 +1,116 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "dll_one_run.h"
+
+
+void hostFail( const char *msg, const char *detail ) {
+  fprintf( stderr, "%s%s\n", msg, detail != NULL ? detail : "" );
+  exit( EXIT_FAILURE );
+}
+
+// Layout of the ports of one kind, and a zeroed buffer for them
+static void* layoutRunPorts( const char *label, const IEEE_Cigre_DLLInterface_Model_Info *modelInfo, DllPortLayout *layout ) {
+
+  int32_T status= buildModelLayout( label, modelInfo, layout );
+
+  if ( status == DLL_LAYOUT_NO_MEMORY ) hostFail( "Memory allocation failed for the port layout", NULL );
+  if ( status != DLL_LAYOUT_OK ) {
+    fprintf( stderr, "%s[%d] : %s has an unsupported data type ( %d )\n", label, status, modelPortName( label, modelInfo, status ),
+             modelPortType( label, modelInfo, status ) );
+    exit( EXIT_FAILURE );
+  }
+
+  void *buffer= calloc( 1, layout -> totalSize > 0 ? layout -> totalSize : 1 );
+  if ( buffer == NULL ) hostFail( "Memory allocation failed for ", label );
+
+  return buffer;
+
+}
+
+// Load a model, lay out its ports and states and build its EMT instance with zeroed buffers and the default parameters
+void loadModelRun( ModelRun *run, const char *modelFile ) {
+
+  run -> hDLL= LoadLibrary( modelFile );
+  if ( run -> hDLL == NULL ) hostFail( "Cannot load model: ", modelFile );
+
+  const char *missing= resolveModelEntries( run -> hDLL, &run -> entries );
+  if ( missing != NULL ) hostFail( "Cannot locate function in model: ", missing );
+
+  IEEE_Cigre_DLLInterface_Model_Info *modelInfo= run -> entries.getInfo();
+  run -> modelInfo= modelInfo;
+
+  if ( modelInfo -> FixedStepBaseSampleTime <= 0 ) hostFail( "The model has no FixedStepBaseSampleTime", NULL );
+
+  void *inputs= layoutRunPorts( "Inputs", modelInfo, &run -> inputs );
+  void *params= layoutRunPorts( "Parameters", modelInfo, &run -> params );
+  void *outputs= layoutRunPorts( "Outputs", modelInfo, &run -> outputs );
+
+  // One packed block for the states, laid out as in 'xvar'
+  DllStateLayout *states= &run -> states;
+  buildStateLayout( states, modelInfo -> NumIntStates, modelInfo -> NumFloatStates, modelInfo -> NumDoubleStates );
+
+  uint8_T *statesBase= calloc( 1, states -> totalSize > 0 ? states -> totalSize : 1 );
+
+  run -> inputValues= calloc( run -> inputs.numValues + 1, sizeof( double ) );
+  run -> paramValues= calloc( run -> params.numValues + 1, sizeof( double ) );
+  run -> outputValues= calloc( run -> outputs.numValues + 1, sizeof( double ) );
+
+  if ( statesBase == NULL || run -> inputValues == NULL || run -> paramValues == NULL || run -> outputValues == NULL ) {
+    hostFail( "Memory allocation failed for the model states", NULL );
+  }
+
+  // All-real64_T inputs are read by the model straight from the 'double' values, as dll_one does with 'xin'
+  if ( run -> inputs.zeroCopy ) {
+    free( inputs );
+    inputs= run -> inputValues;
+  }
+
+  // 'SimTool_EMT_RMS_Mode' is const for the model: the instance is built whole and copied in, as 'dll_one_i' does
+  IEEE_Cigre_DLLInterface_Instance instance= {
+    .ExternalInputs= inputs,
+    .ExternalOutputs= outputs,
+    .Parameters= params,
+    .Time= 0,
+    .SimTool_EMT_RMS_Mode= 1,                                                 // EMT
+    .LastErrorMessage= "",
+    .LastGeneralMessage= "",
+    .IntStates= ( modelInfo -> NumIntStates > 0 ) ? ( int32_T * )( statesBase + states -> intOffset ) : NULL,
+    .FloatStates= ( modelInfo -> NumFloatStates > 0 ) ? ( real32_T * )( statesBase + states -> floatOffset ) : NULL,
+    .DoubleStates= ( modelInfo -> NumDoubleStates > 0 ) ? ( real64_T * )( statesBase + states -> doubleOffset ) : NULL
+  };
+
+  memcpy( &run -> instance, &instance, sizeof( IEEE_Cigre_DLLInterface_Instance ) );
+
+  int32_T i;
+  for ( i= 0; i < modelInfo -> NumParameters; i++ ) {
+    run -> paramValues[i]= defaultParameter( &modelInfo -> ParametersInfo[i] );
+  }
+
+}
+
+// End the process on 'return 2' ( error ), print general messages
+void checkModelCall( ModelRun *run, const char *fcn, int32_T code ) {
+
+  if ( code == 1 && run -> instance.LastGeneralMessage != NULL && run -> instance.LastGeneralMessage[0] != '\0' ) {
+    printf( "%s: %s\n", fcn, run -> instance.LastGeneralMessage );
+  } else if ( code >= 2 ) {
+    fprintf( stderr, "%s failed: %s\n", fcn, run -> instance.LastErrorMessage != NULL ? run -> instance.LastErrorMessage : "" );
+    exit( EXIT_FAILURE );
+  }
+
+}
+
+// Hand the parameters to the model and run Model_FirstCall, Model_CheckParameters and Model_Initialize at time 't'
+void initializeModelRun( ModelRun *run, double t ) {
+
+  changeDataType( run -> paramValues, &run -> params, run -> instance.Parameters );
+  run -> instance.Time= t;
+
+  if ( run -> entries.modelFirstCall != NULL ) {
+    checkModelCall( run, "Model_FirstCall", run -> entries.modelFirstCall( &run -> instance ) );
+  }
+  checkModelCall( run, "Model_CheckParameters", run -> entries.checkParameters( &run -> instance ) );
+  checkModelCall( run, "Model_Initialize", run -> entries.modelInitialize( &run -> instance ) );
+
+}
@@ -0,0 +1,47 @@
+/*
+File: dll_one_run.h
+
+ModelRun, the standalone tools' side of a model dll ( dll_one_driver, model_runner, contingency_fork ): one instance
+of a model with ATP-style 'double' arrays for its ports, loaded and called outside ATP. Its functions print the error
+and end the process instead of stopping a simulation, so they are not part of the ATP image.
+*/
+#ifndef __dll_one_run__
+#define __dll_one_run__
+
+#include "dll_one_host.h"
+
+
+// One model instance run outside ATP ( standalone tools )
+typedef struct _ModelRun
+{
+    HMODULE     hDLL;
+    IEEE_Cigre_DLLInterface_Model_Info *modelInfo;
+    IEEE_Cigre_DLLInterface_Instance instance;
+    DllModelEntries entries;
+
+    DllPortLayout inputs;               // Same layouts and plans as a dll_one module
+    DllPortLayout params;
+    DllPortLayout outputs;
+    DllStateLayout states;
+
+    double *    inputValues;            // ATP-style 'double' arrays
+    double *    paramValues;
+    double *    outputValues;
+} ModelRun;
+
+
+// Print the message and end the process
+void hostFail( const char *msg, const char *detail );
+
+// Load a model, lay out its ports and states and build its EMT instance with zeroed buffers and the default parameters
+void loadModelRun( ModelRun *run, const char *modelFile );
+
+// End the process on 'return 2' ( error ), print general messages
+void checkModelCall( ModelRun *run, const char *fcn, int32_T code );
+
+// Hand the parameters to the model and run Model_FirstCall, Model_CheckParameters and Model_Initialize at time 't',
+// with the inputs already in 'ExternalInputs'
+void initializeModelRun( ModelRun *run, double t );
+
+
+#endif /* __dll_one_run__ */
@@ -0,0 +1,477 @@
+/*
+File: model_runner.c
+
+Standalone host for IEEE/Cigre models built as Linux shared objects: the model runs at its own
+FixedStepBaseSampleTime, without ATP, with the inputs generated by the runner or replayed from a recorded trace. The
+model is loaded and its ports are laid out and converted by the same host code dll_one uses ( dll_one_host.h ),
+all-real64_T inputs are handed to the model in place. At the end the runner reports the steps per second and the time per
+Model_Outputs call.
+
+Usage:
+  model_runner <model.so> [options]
+
+Options ( <input> is a port name or a 1-based input value index, array ports start at their first value ):
+  -t <tEnd>                             simulated time ( default: 1 s )
+  -i <input>=<value>                    constant input value ( default: 0 )
+  -p <name>=<value>                     parameter override ( default: DefaultValue of the model )
+  -sine <input>,<peak>,<freq>[,<deg>]   balanced three-phase set on <input> and the two values after it
+  -step <input>,<t>,<value>             <input> takes <value> from time <t> on
+  -trace <file>                         replay a trace: lines '<t> <v1> <v2> ...', one value per input value, each
+                                        held until the next line, or a '.rec' file of dll_one ( DLL_ONE_RECORD ) with
+                                        its recorded parameters ( later -p options override them ); the first
+                                        record also gives the inputs of the initialization
+  -verify <tol>                         with a '.rec' trace: compare the outputs of every recorded step with the
+                                        recorded ones, fail on a difference above <tol> ( relative to max( 1, |output| ),
+                                        0: identical values )
+  -o <file>                             write the time and the outputs of every step ( slows the run )
+
+Examples:
+  model_runner libgfm_gfl_ibr.so -t 0.5 -sine Va,0.563,60 -i Vref=1
+  model_runner libscrx9.so -t 10 -i VRef=1 -i Ec=1 -i VT=1 -step VRef,1,1.05
+
+Build: make model_runner
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include "IEEE_Cigre_DLLInterface.h"
+#include "dll_one_run.h"
+#include "dll_one_record.h"
+
+
+#define MAX_SINES 16
+#define MAX_STEPS 64
+#define OUTPUT_BUFFER_SIZE ( 1 << 20 )                                        // stdio buffer of the output file
+
+
+// Balanced three-phase set on three consecutive input values
+typedef struct _SineSource {
+  int32_T first;                                                              // 0-based input value of phase A
+  double peak;
+  double omega;                                                               // rad/s
+  double phase;                                                               // rad
+} SineSource;
+
+// Input value changed at a given time
+typedef struct _StepSource {
+  int32_T index;
+  double time;
+  double value;
+} StepSource;
+
+// Recorded input values, held from one time to the next
+typedef struct _TraceSource {
+  int32_T numRecords;
+  double *times;
+  double *values;                                                             // 'numRecords' rows of 'inputs.numValues' values
+  double *outputs;                                                            // '.rec' traces: 'numRecords' rows of 'outputs.numValues' recorded values
+  int32_T next;                                                               // First record not applied yet
+} TraceSource;
+
+
+static SineSource sines[ MAX_SINES ];
+static int32_T numSines= 0;
+static StepSource steps[ MAX_STEPS ];
+static int32_T numSteps= 0;
+static TraceSource trace;
+static double verifyTolerance= -1;                                            // -verify, off when < 0
+
+
+// 0-based input value of a port name or a 1-based index
+static int32_T inputIndex( ModelRun *run, const char *name ) {
+
+  IEEE_Cigre_DLLInterface_Model_Info *modelInfo= run -> modelInfo;
+  int32_T i;
+
+  for ( i= 0; i < modelInfo -> NumInputPorts; i++ ) {
+    if ( strcmp( modelInfo -> InputPortsInfo[i].Name, name ) == 0 ) return run -> inputs.first[i];
+  }
+
+  char *end;
+  long index= strtol( name, &end, 10 );
+  if ( *end != '\0' || index < 1 || index > run -> inputs.numValues ) hostFail( "Unknown input: ", name );
+
+  return ( int32_T )( index - 1 );
+
+}
+
+// Row of the next trace record, the arrays grow as needed ( 'numOutputs' > 0: with the recorded outputs )
+static double* nextTraceRow( int32_T numValues, int32_T numOutputs, int32_T *capRecords ) {
+
+  if ( trace.numRecords == *capRecords ) {
+    *capRecords= ( *capRecords > 0 ) ? 2 * *capRecords : 1024;
+    trace.times= realloc( trace.times, *capRecords * sizeof( double ) );
+    trace.values= realloc( trace.values, ( size_t ) *capRecords * numValues * sizeof( double ) );
+    if ( numOutputs > 0 ) trace.outputs= realloc( trace.outputs, ( size_t ) *capRecords * numOutputs * sizeof( double ) );
+    if ( trace.times == NULL || trace.values == NULL || ( numOutputs > 0 && trace.outputs == NULL ) ) hostFail( "Memory allocation failed for the trace", NULL );
+  }
+
+  return trace.values + ( size_t ) trace.numRecords * numValues;
+
+}
+
+// Text trace: lines '<t> <v1> <v2> ...'
+static void readTextTrace( ModelRun *run, FILE *pFile, const char *traceFile ) {
+
+  int32_T numValues= run -> inputs.numValues;
+  int32_T capRecords= 0;
+  char line[ 16384 ];
+
+  while ( fgets( line, sizeof( line ), pFile ) != NULL ) {
+
+    line[ strcspn( line, "#\r\n" ) ]= '\0';
+    char *word= strtok( line, " \t," );
+    if ( word == NULL ) continue;
+
+    double *values= nextTraceRow( numValues, 0, &capRecords );
+    int32_T i= 0;
+
+    trace.times[ trace.numRecords ]= atof( word );
+    while ( i < numValues && ( word= strtok( NULL, " \t," ) ) != NULL ) {
+      values[ i++ ]= atof( word );
+    }
+
+    if ( i < numValues ) hostFail( "Trace line with fewer values than the model inputs in ", traceFile );
+    trace.numRecords++;
+  }
+
+}
+
+// Record file of dll_one ( dll_one_record.h ): the marshalled inputs of every call back to 'double', and the
+// recorded parameters
+static void readRecordTrace( ModelRun *run, FILE *pFile, const char *traceFile ) {
+
+  IEEE_Cigre_DLLInterface_Model_Info *modelInfo= run -> modelInfo;
+  DllRecordHeader header;
+
+  if ( fread( &header, sizeof( header ), 1, pFile ) != 1 || header.version != DLL_RECORD_VERSION ||
+       header.headerSize != ( int32_T ) sizeof( DllRecordHeader ) ) {
+    hostFail( "Unsupported record file: ", traceFile );
+  }
+
+  if ( strncmp( header.modelName, modelInfo -> ModelName, sizeof( header.modelName ) - 1 ) != 0 ) {
+    hostFail( "Record of another model: ", header.modelName );
+  }
+
+  if ( header.numInputPorts != modelInfo -> NumInputPorts || header.numParameters != modelInfo -> NumParameters ||
+       header.inputsSize != ( int32_T ) run -> inputs.totalSize || header.paramsSize != ( int32_T ) run -> params.totalSize ||
+       header.outputsSize != ( int32_T ) run -> outputs.totalSize ||
+       header.recordSize < ( int32_T )( sizeof( real64_T ) + dllRecordAlign( header.inputsSize ) + header.outputsSize ) ) {
+    hostFail( "Record with other ports than the model: ", traceFile );
+  }
+
+  size_t paramsBytes= dllRecordAlign( ( size_t ) header.paramsSize );
+  size_t bufferSize= ( paramsBytes > ( size_t ) header.recordSize ) ? paramsBytes : ( size_t ) header.recordSize;
+  uint8_T *buffer= malloc( bufferSize );
+
+  if ( buffer == NULL ) hostFail( "Memory allocation failed for the trace", NULL );
+
+  if ( fseek( pFile, ( long ) dllRecordAlign( sizeof( DllRecordHeader ) ), SEEK_SET ) != 0 ||
+       ( paramsBytes > 0 && fread( buffer, paramsBytes, 1, pFile ) != 1 ) ) {
+    hostFail( "Truncated record file: ", traceFile );
+  }
+
+  writeValuesToATP( buffer, &run -> params, run -> paramValues );
+
+  int32_T numValues= run -> inputs.numValues;
+  int32_T numOutputs= run -> outputs.numValues;
+  int32_T capRecords= 0;
+
+  while ( fread( buffer, header.recordSize, 1, pFile ) == 1 ) {                                             // [time][inputs][outputs][states]
+
+    double *values= nextTraceRow( numValues, numOutputs > 0 ? numOutputs : 1, &capRecords );
+
+    memcpy( &trace.times[ trace.numRecords ], buffer, sizeof( real64_T ) );
+    writeValuesToATP( buffer + sizeof( real64_T ), &run -> inputs, values );
+    writeValuesToATP( buffer + sizeof( real64_T ) + dllRecordAlign( header.inputsSize ), &run -> outputs, trace.outputs + ( size_t ) trace.numRecords * numOutputs );
+    trace.numRecords++;
+  }
+
+  // dll_one records the calls after 'dll_one_i': the model was initialized with the inputs of the first one
+  if ( trace.numRecords > 0 ) memcpy( run -> inputValues, trace.values, numValues * sizeof( double ) );
+
+  free( buffer );
+
+}
+
+static void readTrace( ModelRun *run, const char *traceFile ) {
+
+  FILE *pFile= fopen( traceFile, "rb" );
+  if ( pFile == NULL ) hostFail( "Could not read trace: ", traceFile );
+
+  char magic[ sizeof( DLL_RECORD_MAGIC ) ];
+  int32_T isRecord= fread( magic, sizeof( magic ), 1, pFile ) == 1 && memcmp( magic, DLL_RECORD_MAGIC, sizeof( magic ) ) == 0;
+
+  rewind( pFile );
+
+  if ( isRecord ) {
+    readRecordTrace( run, pFile, traceFile );
+  } else {
+    readTextTrace( run, pFile, traceFile );
+  }
+
+  fclose( pFile );
+
+  if ( trace.numRecords == 0 ) hostFail( "Empty trace: ", traceFile );
+
+}
+
+static void readOptions( ModelRun *run, int argc, char *argv[], double *tEnd, const char **outFile ) {
+
+  IEEE_Cigre_DLLInterface_Model_Info *modelInfo= run -> modelInfo;
+  int k;
+
+  for ( k= 2; k < argc; k++ ) {
+
+    const char *option= argv[k];
+    if ( k + 1 == argc ) hostFail( "Missing value of option ", option );
+    char *value= argv[ ++k ];
+
+    if ( strcmp( option, "-t" ) == 0 ) {
+
+      *tEnd= atof( value );
+
+    } else if ( strcmp( option, "-o" ) == 0 ) {
+
+      *outFile= value;
+
+    } else if ( strcmp( option, "-i" ) == 0 || strcmp( option, "-p" ) == 0 ) {
+
+      char *eq= strchr( value, '=' );
+      if ( eq == NULL ) hostFail( "Expected <name>=<value>: ", value );
+      *eq= '\0';
+
+      if ( option[1] == 'i' ) {
+        run -> inputValues[ inputIndex( run, value ) ]= atof( eq + 1 );
+      } else {
+
+        int32_T i;
+        for ( i= 0; i < modelInfo -> NumParameters; i++ ) {
+          if ( strcmp( modelInfo -> ParametersInfo[i].Name, value ) == 0 ) break;
+        }
+
+        if ( i == modelInfo -> NumParameters ) hostFail( "Unknown parameter: ", value );
+        run -> paramValues[i]= atof( eq + 1 );
+      }
+
+    } else if ( strcmp( option, "-sine" ) == 0 ) {
+
+      if ( numSines == MAX_SINES ) hostFail( "Too many -sine sources", NULL );
+
+      SineSource *sine= &sines[ numSines++ ];
+      char *name= strtok( value, "," );
+      char *peak= strtok( NULL, "," );
+      char *freq= strtok( NULL, "," );
+      char *deg= strtok( NULL, "," );
+
+      if ( name == NULL || peak == NULL || freq == NULL ) hostFail( "Expected -sine <input>,<peak>,<freq>[,<deg>]", NULL );
+
+      sine -> first= inputIndex( run, name );
+      sine -> peak= atof( peak );
+      sine -> omega= 2 * M_PI * atof( freq );
+      sine -> phase= ( deg != NULL ) ? atof( deg ) * M_PI / 180 : 0;
+
+      if ( sine -> first + 3 > run -> inputs.numValues ) hostFail( "Not enough input values after ", name );
+
+    } else if ( strcmp( option, "-step" ) == 0 ) {
+
+      if ( numSteps == MAX_STEPS ) hostFail( "Too many -step sources", NULL );
+
+      StepSource *step= &steps[ numSteps++ ];
+      char *name= strtok( value, "," );
+      char *time= strtok( NULL, "," );
+      char *level= strtok( NULL, "," );
+
+      if ( name == NULL || time == NULL || level == NULL ) hostFail( "Expected -step <input>,<t>,<value>", NULL );
+
+      step -> index= inputIndex( run, name );
+      step -> time= atof( time );
+      step -> value= atof( level );
+
+    } else if ( strcmp( option, "-trace" ) == 0 ) {
+
+      readTrace( run, value );
+
+    } else if ( strcmp( option, "-verify" ) == 0 ) {
+
+      verifyTolerance= atof( value );
+      if ( verifyTolerance < 0 ) hostFail( "Invalid -verify tolerance: ", value );
+
+    } else {
+      hostFail( "Unknown option: ", option );
+    }
+
+  }
+
+}
+
+// Input values at time 't': trace first, then the steps and the sine sets on top
+static inline void generateInputs( ModelRun *run, double t ) {
+
+  int32_T numValues= run -> inputs.numValues;
+  int32_T k;
+
+  while ( trace.next < trace.numRecords && trace.times[ trace.next ] <= t ) {
+    memcpy( run -> inputValues, trace.values + ( size_t ) trace.next * numValues, numValues * sizeof( double ) );
+    trace.next++;
+  }
+
+  for ( k= 0; k < numSteps; k++ ) {
+    if ( t >= steps[k].time ) run -> inputValues[ steps[k].index ]= steps[k].value;
+  }
+
+  for ( k= 0; k < numSines; k++ ) {
+    const SineSource *sine= &sines[k];
+    double angle= sine -> omega * t + sine -> phase;
+    run -> inputValues[ sine -> first ]= sine -> peak * sin( angle );
+    run -> inputValues[ sine -> first + 1 ]= sine -> peak * sin( angle - 2 * M_PI / 3 );
+    run -> inputValues[ sine -> first + 2 ]= sine -> peak * sin( angle + 2 * M_PI / 3 );
+  }
+
+  if ( !run -> inputs.zeroCopy ) {
+    changeDataType( run -> inputValues, &run -> inputs, run -> instance.ExternalInputs );
+  }
+
+}
+
+// -verify: largest output difference ( relative to max( 1, |recorded| ) ) of the steps that replayed a record at
+// their own time, and the number of them
+static double verifyMax= 0;
+static int64_t verifySteps= 0;
+
+static void verifyOutputs( ModelRun *run, double t, double dt ) {
+
+  if ( trace.next == 0 || fabs( trace.times[ trace.next - 1 ] - t ) > 1e-9 * dt ) return;                    // No model call recorded at 't'
+
+  const double *recorded= trace.outputs + ( size_t )( trace.next - 1 ) * run -> outputs.numValues;
+  int32_T i;
+
+  writeValuesToATP( run -> instance.ExternalOutputs, &run -> outputs, run -> outputValues );
+
+  for ( i= 0; i < run -> outputs.numValues; i++ ) {
+
+    double scale= fabs( recorded[i] ) > 1 ? fabs( recorded[i] ) : 1;
+    double difference= fabs( run -> outputValues[i] - recorded[i] ) / scale;
+
+    if ( !( difference <= verifyMax ) ) verifyMax= difference;                                               // NaN on either side counts as a difference
+    if ( !( difference <= verifyTolerance ) && verifyMax == difference ) {
+      printf( "Verify: t= %.9g output %d = %.17g, recorded %.17g\n", t, i + 1, run -> outputValues[i], recorded[i] );
+    }
+  }
+
+  verifySteps++;
+
+}
+
+static inline double nowNs( void ) {
+
+  struct timespec ts;
+  clock_gettime( CLOCK_MONOTONIC, &ts );
+
+  return ts.tv_sec * 1e9 + ts.tv_nsec;
+
+}
+
+
+int main( int argc, char *argv[] ) {
+
+  if ( argc < 2 ) {
+    printf( "Usage: %s <model.so> [-t tEnd] [-i input=value] [-p param=value] [-sine input,peak,freq[,deg]] [-step input,t,value] [-trace file] [-verify tol] [-o file]\n", argv[0] );
+    return EXIT_FAILURE;
+  }
+
+  ModelRun run;
+  memset( &run, 0, sizeof( run ) );
+
+  double tEnd= 1.0;
+  const char *outFile= NULL;
+
+  loadModelRun( &run, argv[1] );
+  readOptions( &run, argc, argv, &tEnd, &outFile );
+  if ( verifyTolerance >= 0 && trace.outputs == NULL ) hostFail( "-verify needs a '.rec' trace", NULL );
+
+  FILE *pFile= NULL;
+  if ( outFile != NULL ) {
+    pFile= fopen( outFile, "w" );
+    if ( pFile == NULL ) hostFail( "Cannot write ", outFile );
+    setvbuf( pFile, NULL, _IOFBF, OUTPUT_BUFFER_SIZE );
+  }
+
+  double dt= run.modelInfo -> FixedStepBaseSampleTime;
+  int64_t lastStep= ( int64_t )( tEnd / dt + 0.5 );
+
+  printf( "Model= %s - dt= %g - tEnd= %g ( %lld steps ) - %d inputs ( zero-copy= %d ), %d outputs\n", run.modelInfo -> ModelName, dt, tEnd,
+          ( long long ) lastStep, run.inputs.numValues, run.inputs.zeroCopy, run.outputs.numValues );
+
+
+  // Initialization with the inputs at t= 0
+
+  generateInputs( &run, 0 );
+  initializeModelRun( &run, 0 );
+
+  // Time loop, Model_Outputs timed on its own
+
+  IEEE_Cigre_DLLInterface_Instance *instance= &run.instance;
+  ModelCall modelOutputs= run.entries.modelOutputs;
+  double modelNs= 0;
+  int64_t n;
+  int32_T i;
+
+  double clockNs= nowNs();                                                                                   // Cost of one clock reading, taken off the model time
+  for ( i= 0; i < 1000; i++ ) nowNs();
+  clockNs= ( nowNs() - clockNs ) / 1001;
+
+  double t0= nowNs();
+
+  for ( n= 1; n <= lastStep; n++ ) {
+
+    double t= n * dt;
+
+    generateInputs( &run, t );
+    instance -> Time= t;
+
+    double c0= nowNs();
+    int32_T code= modelOutputs( instance );
+    modelNs += nowNs() - c0 - clockNs;
+
+    if ( code != 0 ) checkModelCall( &run, "Model_Outputs", code );
+
+    if ( verifyTolerance >= 0 ) verifyOutputs( &run, t, dt );
+
+    if ( pFile != NULL ) {
+      writeValuesToATP( instance -> ExternalOutputs, &run.outputs, run.outputValues );
+      fprintf( pFile, "%.9g", t );
+      for ( i= 0; i < run.outputs.numValues; i++ ) fprintf( pFile, " %.12g", run.outputValues[i] );
+      fputc( '\n', pFile );
+    }
+
+  }
+
+  double totalNs= nowNs() - t0;
+
+  if ( run.entries.modelTerminate != NULL ) {
+    run.entries.modelTerminate( instance );
+  }
+
+  if ( pFile != NULL && fclose( pFile ) != 0 ) hostFail( "Cannot write ", outFile );
+
+  writeValuesToATP( instance -> ExternalOutputs, &run.outputs, run.outputValues );
+
+  printf( "Steps= %lld in %.3f ms - %.0f steps/s ( %.0f x real time )\n", ( long long ) lastStep, totalNs / 1e6,
+          totalNs > 0 ? lastStep / ( totalNs / 1e9 ) : 0, totalNs > 0 ? tEnd / ( totalNs / 1e9 ) : 0 );
+  printf( "Model_Outputs= %.1f ns per call\n", lastStep > 0 ? modelNs / lastStep : 0 );
+  printf( "Outputs( t= %g )=", lastStep * dt );
+  for ( i= 0; i < run.outputs.numValues; i++ ) printf( " %.6g", run.outputValues[i] );
+  printf( "\n" );
+
+  if ( verifyTolerance >= 0 ) {
+
+    printf( "Verify: %lld recorded steps, largest output difference %g\n", ( long long ) verifySteps, verifyMax );
+    if ( verifySteps == 0 || !( verifyMax <= verifyTolerance ) ) return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+
+}